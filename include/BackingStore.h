@@ -0,0 +1,87 @@
+#ifndef BACKING_STORE_H
+#define BACKING_STORE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class Process; // Forward declaration
+
+// Preallocated binary swap file divided into fixed-size slots. A record larger than
+// one slot is scattered over several; the file doubles when every slot is taken.
+// Writes are queued for a swap daemon thread that flushes them in slot order, so
+// callers only wait for file I/O when the bounded queue is full.
+class BackingStore {
+public:
+    static constexpr size_t NO_SLOT = static_cast<size_t>(-1);
+
+    BackingStore(const std::string& path, size_t slotBytes, size_t initialSlots);
+    ~BackingStore();
+
+    std::vector<size_t> write(const char* data, size_t bytes);  // Queues a record, returns its slots
+    void read(const std::vector<size_t>& slots, char* data, size_t bytes);
+    void release(const std::vector<size_t>& slots);
+
+    // Whole-process images for contiguous allocators: the interpreter state followed by memory,
+    // which may be empty when the allocator keeps no contents
+    std::vector<size_t> swapOutProcess(Process& process, const char* memory, size_t bytes);
+    void swapInProcess(Process& process, const std::vector<size_t>& slots, char* memory, size_t bytes);
+
+    // Human-readable eviction log kept in backingstore.txt, off unless enabled
+    void setDebugLog(bool enabled);
+    void setQueueLimit(size_t slots);  // Slots that may wait for the daemon before write blocks
+    void logSwapOut(Process& process, const std::string& detail);
+
+    size_t getSlotBytes() const;
+    size_t getBytesWritten();
+    size_t getBytesRead();
+    void printStats(std::ostream& out);
+
+private:
+    struct ProcessHeader {
+        size_t pid;
+    };
+
+    // A slot's contents between write and the daemon flushing them
+    struct PendingWrite {
+        std::vector<char> data;
+        size_t version;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    void grow(size_t slots);  // Extends the file and the free list to hold slots
+    void runDaemon();
+
+    std::string path;
+    std::fstream file;
+    std::mutex fileMutex;           // Taken after storeMutex, never before it
+    size_t slotBytes;
+    size_t capacity = 0;            // Slots the file currently holds
+    std::vector<size_t> freeSlots;
+    size_t bytesWritten = 0;
+    size_t bytesRead = 0;
+    bool debugLog = false;
+    std::mutex storeMutex;
+
+    std::unordered_map<size_t, PendingWrite> pending;  // Slot -> data not yet in the file
+    std::deque<size_t> writeQueue;                       // Slots in the order they were queued
+    size_t queueLimit = 256;
+    size_t nextVersion = 0;
+    size_t maxQueueDepth = 0;
+    size_t nFlushedWrites = 0;
+    size_t nBatches = 0;
+    double totalWriteLatencyUs = 0;
+    bool stopping = false;
+    std::condition_variable workCondition;   // Daemon waits for queued writes
+    std::condition_variable spaceCondition;  // Writers wait for room in the queue
+    std::thread daemonThread;
+};
+
+#endif // BACKING_STORE_H
@@ -0,0 +1,72 @@
+#ifndef BUDDY_MEMORY_ALLOCATOR_H
+#define BUDDY_MEMORY_ALLOCATOR_H
+
+#include <vector>
+#include <iostream>
+#include "IMemoryAllocator.h"
+#include "ResidentBlocks.h"
+#include <mutex>
+#include <map>
+#include <set>
+#include <atomic>
+
+// Binary buddy allocator: every request is rounded up to a power of two and
+// carved out of a contiguous pool by splitting larger blocks in halves. Freed
+// blocks are merged back with their buddy whenever both halves are free.
+class BuddyMemoryAllocator : public IMemoryAllocator {
+public:
+    BuddyMemoryAllocator(size_t maximumSize, size_t mem_per_frame);
+    ~BuddyMemoryAllocator();
+
+    void* allocate(std::shared_ptr<Process> process) override;
+    void deallocate(std::shared_ptr<Process> process) override;
+    void visualizeMemory() override;
+    int getNProcess()override; 
+    std::map<size_t, std::shared_ptr<Process>>getProcessList()override;
+    size_t getMaxMemory()override;
+    size_t getExternalFragmentation()override;
+    size_t getLargestFreeBlock()override;
+    size_t getFreeBlockCount()override;
+    bool deallocateOldest(size_t memSize)override;
+    size_t getPageIn()override;
+    size_t getPageOut()override;
+    size_t getInternalFragmentation()override;
+    void printStats(std::ostream& out)override;
+    int accessPage(Process& process, size_t page)override;
+    size_t getResidentMemory(const Process& process)override;
+    void setReplacementPolicy(std::unique_ptr<ReplacementPolicy> policy)override;
+    BackingStore& getBackingStore()override;
+    void setReclaimWatermarks(int lowPercent, int highPercent)override;
+    bool pin(std::shared_ptr<Process> process)override;
+    void unpin(std::shared_ptr<Process> process)override;
+    size_t getReleaseCount()override;
+    void setReleaseListener(std::function<void()> listener)override;
+
+private:
+    size_t maximumSize;          // Total size of the memory pool
+    size_t mem_per_frame;
+    size_t maxOrder;             // Largest block is 2^maxOrder KB
+    std::atomic<size_t> freeSize;  // Sum of all free blocks
+    std::atomic<size_t> largestFree;  // Refreshed whenever a free list changes, read without the lock
+    std::atomic<size_t> nFreeBlocks;
+    size_t internalFragmentation;  // Rounding waste inside allocated blocks
+    size_t nSplits;
+    size_t nCoalesces;
+    std::vector<char> memory;    // Memory pool representation
+    std::vector<std::set<size_t>> freeLists;  // Free block offsets, indexed by order
+    std::map<size_t, size_t> blockOrder;      // Allocated block offset -> order
+    int nProcess;
+
+    static size_t orderFor(size_t size);          // Smallest order whose block holds size
+    void insertFreeBlock(size_t index, size_t order);  // Frees a block, merging with its buddies
+    size_t largestFreeBlock() const;
+    void releaseBlock(size_t index, Process& process);  // Frees a resident process's block, lock held
+    bool evictVictim();  // Swaps out an unpinned victim; false when there is none
+    std::mutex memoryMutex;
+    BackingStore backingStore;
+    ResidentBlocks residentBlocks;  // Pins, replacement order and swap images of the blocks in processList
+    std::map<size_t, std::shared_ptr<Process>> processList; //index of starting memory, name, size
+    MemoryReclaimer reclaimer;  // Its thread calls evictVictim, so it must be the first member destroyed
+};
+
+#endif // BUDDY_MEMORY_ALLOCATOR_H
@@ -1,10 +1,14 @@
 #ifndef CPU_CLOCK_H
 #define CPU_CLOCK_H
 #include <atomic>
+#include <chrono>
+#include <climits>
 #include <condition_variable>
 #include <iostream>
-#include <thread>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <string>
 
 class CPUClock {
 public:
@@ -13,18 +17,73 @@ public:
     void startCPUClock();
     void stopCPUClock();
     std::atomic<int> getActiveCPUNum();
-    void incrementActiveCPUNum();
-    
-    // Accessors to use condition variable and mutex externally
-    std::condition_variable& getCondition() { return cycleCondition; }
-    std::mutex& getMutex() { return clockMutex; }
+    void incrementActiveCPUNum(int ticks = 1);
+
+    // "wall" ticks once per millisecond, "virtual" jumps straight to the next tick someone waits for
+    void setClockMode(const std::string& mode);
+    bool isVirtual() const;
+
+    // Participants get a slot with its own epoch; call before startCPUClock to size the slot table
+    void reserveParticipants(int n);
+    int registerParticipant();
+    int getParticipantCount() const;
+
+    // Participants hold back the virtual clock while they have work for the current tick
+    void joinParticipant(int slot);
+    void leaveParticipant(int slot);
+
+    // Hold the current tick for a participant that will join later (e.g. a core being woken)
+    void holdTick();
+    void joinHeldParticipant(int slot);
+
+    // Parks the participant until the clock reaches the given tick and returns the current tick
+    int waitForTick(int slot, int tick);
+
+    // Waits until the clock moves past lastTick without holding it back (observers)
+    int waitForAdvance(int lastTick);
+
+    // Host process CPU time spent per simulated tick since the clock started
+    double getHostMicrosPerTick();
+    double getHostCpuSeconds();  // Host process CPU time since the clock started
 
 private:
+    static const int TICK_RUNNING = -1;     // Slot is working on the current tick
+    static const int TICK_IDLE = INT_MAX;   // Slot does not take part in the barrier
+
+    struct alignas(64) TickSlot {
+        std::atomic<int> wake{TICK_IDLE};   // Tick the participant is parked until
+        std::mutex mutex;                   // Wall clock only: the participant sleeps on parked
+        std::condition_variable parked;
+    };
+
+    void tryAdvance();
+    void advance();
+    int waitForTickParked(int slot, int tick);
+    int waitForTickObserved(int tick, std::chrono::milliseconds timeout);
+    void wakeParked(int tick);
+    static void backoff(int& spins);
+    static double hostCpuSeconds();
+
     std::atomic<int> cpuClock;
-    bool isRunning = false;
+    std::atomic<bool> isRunning{false};
+    bool virtualTime = false;
     std::thread CPUClockThread;
-    std::condition_variable cycleCondition;
-    std::mutex clockMutex;
     std::atomic<int> activeNum;
+
+    std::unique_ptr<TickSlot[]> slots;
+    int slotCapacity = 0;
+    std::atomic<int> nSlots{0};
+    std::atomic<int> pendingParticipants{0};   // Participants (and holds) still busy on this tick
+    std::atomic_flag advancing = ATOMIC_FLAG_INIT;
+    std::atomic<unsigned> arrivals{0};          // Bumped on every arrival so an advancer can tell it raced one
+
+    // Waiters without a slot (observers) share one condition variable, notified on every tick
+    // while any of them waits. Participants never touch it.
+    std::mutex observerMutex;
+    std::condition_variable observerCondition;
+    std::atomic<int> nParkedObservers{0};
+
+    double hostCpuAtStart = 0;
+    int tickAtStart = 0;
 };
 #endif
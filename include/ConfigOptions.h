@@ -0,0 +1,39 @@
+#ifndef CONFIG_OPTIONS_H
+#define CONFIG_OPTIONS_H
+
+#include <iostream>
+#include <string>
+
+// Optional settings that may follow the fixed entries of config.txt as "key value" pairs
+struct ConfigOptions
+{
+    std::string clock_mode = "wall";    // "wall" or "virtual"
+    std::string exec_mode = "threads";  // "threads" (one host thread per core) or "pool"
+    int host_threads = 0;               // Pool size, 0 = host core count
+    int context_switch_cycles = 2;      // Cycles a core spends switching out an RR process
+    std::string mem_allocator = "auto"; // "auto" (flat when one frame spans memory, else paging), "flat", "paging" or "buddy"
+    std::string page_access = "locality";  // Pages touched under demand paging: "sequential", "random" or "locality"
+    int minor_fault_cycles = 1;         // Stall for the first touch of a page
+    int major_fault_cycles = 10;        // Stall for a page brought back from the backing store
+    std::string replacement_policy = "fifo";  // "fifo", "lru", "clock"/"second-chance" or "working-set"
+    int working_set_window = 1000;      // References a unit stays in the working set after its last use
+    int swap_debug_log = 0;             // 1 also appends a readable entry per swap-out to backingstore.txt
+    int swap_queue_depth = 256;         // Swap slots that may wait for the swap daemon before eviction blocks
+    int reclaim_low_watermark = 0;      // Percent of memory; below it the reclaimer starts evicting, 0 = off
+    int reclaim_high_watermark = 0;     // Percent of memory the reclaimer frees up to
+    std::string flat_placement = "first-fit";  // Flat allocator: "first-fit", "best-fit", "worst-fit", "next-fit" or "segregated"
+    int compaction_threshold = 0;       // Flat allocator: external fragmentation percent that triggers compaction, 0 = only when placement fails
+    int compaction_budget = 4096;       // Flat allocator: KB one compaction pass may move, 0 = never compact
+    std::string frame_placement = "scattered";  // Paging: "scattered" (any free frame on demand) or "contiguous" (one run, mapped up front)
+    int huge_frame_multiple = 0;        // Paging: base frames per huge frame for processes that span one, 0 or 1 = off
+    std::string process_output = "none";  // PRINT output: "none", "files" (one <process>.txt each) or "log" (process_output.log with an index)
+    int blocking_percent = 2;           // Percent of generated statements that SLEEP or wait on IO off the core
+
+    // Reads the value for key; returns false for unknown keys
+    bool parse(const std::string& key, std::istream& in);
+
+    // Displays the values the same way "initialize" shows the fixed settings
+    void print(std::ostream& out) const;
+};
+
+#endif // CONFIG_OPTIONS_H
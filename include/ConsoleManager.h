@@ -4,6 +4,7 @@
 #include "ProcessManager.h"
 #include "ConsoleScreen.h"
 #include "CPUClock.h"
+#include "ConfigOptions.h"
 
 #include <string>
 #include <map>
@@ -24,10 +25,12 @@ class ConsoleManager
     bool initialized = false;
     bool schedulerRunning = false;
     CPUClock* cpuClock;
+    int generatorSlot = -1;
     size_t max_mem;
     size_t mem_per_frame;
     size_t min_mem_per_proc;
     size_t max_mem_per_proc;
+    ConfigOptions options;
 
 
 private:
@@ -4,12 +4,25 @@
 #include <vector>
 #include <iostream>
 #include "IMemoryAllocator.h"
+#include "ResidentBlocks.h"
 #include <mutex>
 #include <map>
+#include <atomic>
+#include <set>
+#include <string>
 
 
 class FlatMemoryAllocator : public IMemoryAllocator {
 public:
+    // Which free block receives a request
+    enum class Placement {
+        FIRST_FIT,   // Lowest address that fits
+        BEST_FIT,    // Smallest block that fits
+        WORST_FIT,   // Largest block
+        NEXT_FIT,    // First fit, resuming after the previous placement
+        SEGREGATED   // Power-of-two size classes, searched from the request's class upwards
+    };
+
     FlatMemoryAllocator(size_t maximumSize, size_t mem_per_frame);
     ~FlatMemoryAllocator();
 
@@ -20,26 +33,76 @@ public:
     std::map<size_t, std::shared_ptr<Process>>getProcessList()override;
     size_t getMaxMemory()override;
     size_t getExternalFragmentation()override;
-    void deallocateOldest(size_t memSize)override;
+    size_t getLargestFreeBlock()override;
+    size_t getFreeBlockCount()override;
+    bool deallocateOldest(size_t memSize)override;
     size_t getPageIn()override;
     size_t getPageOut()override;
+    size_t getInternalFragmentation()override;
+    void printStats(std::ostream& out)override;
+    int accessPage(Process& process, size_t page)override;
+    size_t getResidentMemory(const Process& process)override;
+    void setReplacementPolicy(std::unique_ptr<ReplacementPolicy> policy)override;
+    BackingStore& getBackingStore()override;
+    void setReclaimWatermarks(int lowPercent, int highPercent)override;
+    bool pin(std::shared_ptr<Process> process)override;
+    void unpin(std::shared_ptr<Process> process)override;
+    size_t getReleaseCount()override;
+    void setReleaseListener(std::function<void()> listener)override;
+    void setPlacement(const std::string& name);  // "first-fit", "best-fit", "worst-fit", "next-fit" or "segregated"
+    void setCompaction(int thresholdPercent, size_t budget);  // See compact(); a budget of 0 disables compaction
 
 
 private:
     size_t maximumSize;          // Total size of the memory pool
     size_t mem_per_frame;
     size_t allocatedSize;        // Currently allocated size
-    std::vector<char> memory;    // Memory pool representation
-    std::vector<bool> allocationMap;  // Allocation tracking map
     int nProcess;
 
-    void initializeMemory();                      // Initializes memory and allocation map
+    void initializeMemory();                      // Initializes the free block indexes
+    static void* toHandle(size_t index);          // Opaque non-null handle stored on the process
+    static size_t toIndex(const void* handle);    // Offset of a handle, NO_BLOCK for null
     bool canAllocateAt(size_t index, size_t size) const;  // Checks if memory can be allocated at an index
+    size_t findFreeBlock(size_t size);            // Start of the block chosen by the placement, NO_BLOCK if none fits
+    void addFreeBlock(size_t index, size_t size); // Records a free block in every index
+    void removeFreeBlock(std::map<size_t, size_t>::iterator it);
+    size_t sizeClass(size_t size) const;          // floor(log2(size)), the segregated list of a block
+    bool findCompactionRegion(size_t size, size_t& regionStart, size_t& regionEnd) const;  // Between pinned blocks
+    bool compact(size_t size);  // Slides unpinned blocks down until size fits or the budget is spent; true if any moved
     void allocateAt(size_t index, size_t size);   // Marks a block of memory as allocated
     void deallocateAt(size_t index, size_t size);              // Frees an allocated block of memory starting at index
+    void releaseBlock(size_t index, Process& process);  // Frees a resident process's block, lock held
+    bool evictVictim();  // Swaps out an unpinned victim; false when there is none
     std::mutex memoryMutex;
+    BackingStore backingStore;
+    ResidentBlocks residentBlocks;  // Pins, replacement order and swap images of the blocks in processList
     std::map<size_t, std::shared_ptr<Process>> processList; //index of starting memory, name, size
-    std::map<size_t, size_t> freeBlocks;
+    std::map<size_t, size_t> freeBlocks;  // Free block start -> size, ordered by address for merging
+    std::set<std::pair<size_t, size_t>> freeBySize;  // (size, start) of every free block
+    std::vector<std::set<size_t>> sizeClasses;  // Free block starts, indexed by sizeClass
+    static constexpr size_t NO_BLOCK = static_cast<size_t>(-1);
+    // Contents are not modelled, so a swap image is just the interpreter state and fits one
+    // small slot; the swap file then scales with swapped processes, not with memory size
+    static constexpr size_t SWAP_SLOT_BYTES = 256;
+    static constexpr size_t INITIAL_SWAP_SLOTS = 64;
+    // Kept up to date by addFreeBlock/removeFreeBlock so statistics never take memoryMutex
+    std::atomic<size_t> freeBytes{0};
+    std::atomic<size_t> largestFree{0};
+    std::atomic<size_t> nFreeBlocks{0};
+
+    Placement placement;
+    size_t nextFitCursor;        // Where the next next-fit search starts
+    size_t nPlacements;          // Searches, including the ones that found nothing
+    size_t nFailedPlacements;
+    size_t placementNanos;       // Host time spent searching for blocks
+    double fragmentationSum;     // External fragmentation sampled after each placement
+    double peakFragmentation;
+    int compactionThreshold;     // External fragmentation percent that compacts before placing, 0 = only on failure
+    size_t compactionBudget;     // KB one compaction pass may move while holding memoryMutex
+    size_t nCompactions;         // Passes that moved at least one block
+    size_t compactedSize;        // KB moved by compaction
+    size_t nEvictionsAvoided;    // Failed placements that compaction turned into successes
+    MemoryReclaimer reclaimer;  // Its thread calls evictVictim, so it must be the first member destroyed
 };
 
 #endif // FLAT_MEMORY_ALLOCATOR_H
@@ -0,0 +1,42 @@
+#ifndef FRAME_BITMAP_H
+#define FRAME_BITMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Set of free frames, one bit per frame (1 = free). Searches scan a 64-bit word at a
+// time with count-trailing-zeros, so runs of allocated frames are skipped in bulk.
+class FrameBitmap {
+public:
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+
+    explicit FrameBitmap(size_t nFrames = 0);  // Every frame starts out free
+
+    size_t size() const;   // Frames tracked, free or not
+    size_t count() const;  // Free frames
+    bool isFree(size_t frame) const;
+
+    size_t takeAny();                                       // Lowest free frame, NONE if there is none
+    size_t takeRun(size_t length, size_t alignment = 1);    // First aligned run of free frames, NONE if there is none
+    bool release(size_t frame);                             // False, and no change, if the frame was already free
+    void releaseRun(size_t first, size_t length);
+
+    size_t countSlow() const;  // Popcount of every word, to check count() against
+
+    static size_t countTrailingZeros(uint64_t word);  // Index of the lowest set bit; word must not be 0
+
+private:
+    size_t nextFree(size_t from) const;                 // First free frame at or after from, NONE if none
+    size_t firstTaken(size_t from, size_t to) const;    // First allocated frame in [from, to), NONE if none
+    void clearRun(size_t first, size_t length);
+
+    static size_t popCount(uint64_t word);
+
+    std::vector<uint64_t> words;
+    size_t nFrames;
+    size_t nFree;
+    size_t searchHint;  // No word below this one has a free bit
+};
+
+#endif // FRAME_BITMAP_H
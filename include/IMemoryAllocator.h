@@ -2,11 +2,15 @@
 #define IMEMORYALLOCATOR_H
 
 #include <vector>
+#include <functional>
 #include <unordered_map>
 #include <iostream>
 #include <map>
 #include <tuple>
 #include "Process.h"
+#include "ReplacementPolicy.h"
+#include "BackingStore.h"
+#include "MemoryReclaimer.h"
 
 class IMemoryAllocator {
     public:
@@ -16,9 +20,24 @@ class IMemoryAllocator {
         virtual int getNProcess() = 0; 
         virtual std::map<size_t, std::shared_ptr<Process>>getProcessList() = 0;
         virtual size_t getMaxMemory() = 0;
-        virtual size_t getExternalFragmentation() = 0;
-        virtual void deallocateOldest(size_t memSize) = 0;
+        virtual size_t getExternalFragmentation() = 0;  // Free KB
+        virtual size_t getLargestFreeBlock() = 0;  // KB of the largest request that fits without evicting
+        virtual size_t getFreeBlockCount() = 0;
+        virtual bool deallocateOldest(size_t memSize) = 0;  // Makes room without waiting, false if nothing could be freed
         virtual size_t getPageIn() = 0;
         virtual size_t getPageOut() = 0;
+        virtual size_t getInternalFragmentation() = 0;  // Allocated but unused KB
+        virtual void printStats(std::ostream& out) = 0;  // Allocator-specific vmstat lines
+        virtual int accessPage(Process& process, size_t page) = 0;  // Returns the fault cycles of the touch
+        virtual size_t getResidentMemory(const Process& process) = 0;  // KB the process holds right now
+        virtual void setReplacementPolicy(std::unique_ptr<ReplacementPolicy> policy) = 0;
+        virtual BackingStore& getBackingStore() = 0;
+        virtual void setReclaimWatermarks(int lowPercent, int highPercent) = 0;  // Percent of memory kept free
+        virtual bool pin(std::shared_ptr<Process> process) = 0;  // Protects a resident process from eviction, false if not resident
+        virtual void unpin(std::shared_ptr<Process> process) = 0;  // The process left its core and may be evicted again
+        // Unpins and frees so far, and a listener called after each one without the allocator's lock.
+        // A dispatch that finds every resident process pinned waits for the count to move.
+        virtual size_t getReleaseCount() = 0;
+        virtual void setReleaseListener(std::function<void()> listener) = 0;
 };
 #endif // IMEMORYALLOCATOR_H
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef INSTRUCTION_SOURCE_H
+#define INSTRUCTION_SOURCE_H
+
+#include "Program.h"
+
+#include <cstdint>
+
+// A process's instruction stream, described by a seed and a length. Instructions are
+// generated a block at a time as execution reaches them; each block is a pure function
+// of the seed and its position, so only the block being executed is held. Loops never
+// cross a block, and every block runs a known number of instructions, so the stream
+// executes exactly length instructions however its loops nest.
+class InstructionSource {
+public:
+    static constexpr int BLOCK_BUDGET = 64;  // Instructions one block executes, loop iterations included
+
+    InstructionSource(uint32_t seed = 0, int length = 0, int blockingPercent = 0);  // blockingPercent of statements SLEEP or do IO
+
+    int size() const;                     // Instructions executed over the whole stream
+    const Program& nextBlock(int remaining);  // Generates the block after the current one, running at most remaining instructions
+    const Program& currentBlock() const;
+    void release();                       // Drops the current block
+    size_t getFootprint() const;          // Bytes held by the current block
+
+private:
+    int emitStatement(uint32_t& rng, int budget, int depth);  // Returns the instructions it executes
+
+    uint32_t seed;
+    int length;
+    uint32_t blockingPercent;
+    int blockIndex = -1;
+    Program block;
+};
+
+#endif // INSTRUCTION_SOURCE_H
@@ -0,0 +1,42 @@
+#ifndef MEMORY_RECLAIMER_H
+#define MEMORY_RECLAIMER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+// Background reclaim thread for an allocator. When free memory drops below the low
+// watermark it evicts until free memory reaches the high watermark, so allocations on
+// the dispatch path rarely have to evict themselves. Amounts are in the allocator's
+// own units (frames, KB) and must be read without holding the allocator's lock.
+class MemoryReclaimer {
+public:
+    MemoryReclaimer(std::function<size_t()> freeAmount, std::function<bool()> reclaimOne);
+    ~MemoryReclaimer();
+
+    void setWatermarks(size_t low, size_t high);  // A low watermark of 0 disables the thread
+    void noteFree(size_t free);                   // Called by the allocator after it hands out memory
+    void recordDirectReclaim();                   // An allocation had to evict on its own
+    void printStats(std::ostream& out) const;
+
+private:
+    void run();
+
+    std::function<size_t()> freeAmount;
+    std::function<bool()> reclaimOne;  // Evicts one victim, false when nothing could be evicted
+    std::atomic<size_t> lowWatermark{0};
+    std::atomic<size_t> highWatermark{0};
+    std::atomic<size_t> directReclaims{0};
+    std::atomic<size_t> backgroundReclaims{0};
+    std::atomic<size_t> wakeups{0};
+    bool woken = false;
+    bool stopping = false;
+    std::mutex reclaimMutex;
+    std::condition_variable reclaimCondition;
+    std::thread reclaimThread;
+};
+
+#endif // MEMORY_RECLAIMER_H
@@ -0,0 +1,94 @@
+#ifndef OUTPUT_LOG_H
+#define OUTPUT_LOG_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class CPUClock;
+
+// Sink for PRINT output. Each host thread that executes instructions appends fixed-size
+// records to its own single-producer ring, without locks or formatting; a background
+// writer drains every ring, groups the records by process and writes each group with one
+// open, either to "<process>.txt" or to one log with an index of each group's offset.
+// A process that moves between threads leaves records in several rings, so the writer puts
+// them back in print order by their sequence numbers.
+class OutputLog {
+public:
+    OutputLog(CPUClock* cpuClock, const std::string& mode);  // mode "files" or "log"
+    ~OutputLog();
+
+    void registerProcess(size_t pid, const std::string& name);  // Name that replaces %s in its output
+    void print(int core, size_t pid, uint32_t sequence, uint16_t message, uint16_t value, bool hasValue);  // sequence counts the process's prints from 0
+    void flush();  // Returns once every record printed so far is written
+    void printStats(std::ostream& out) const;
+
+private:
+    struct Record {
+        size_t pid;
+        uint32_t sequence;
+        int tick;
+        int16_t core;
+        uint16_t message;  // Program string
+        uint16_t value;
+        bool hasValue;
+    };
+
+    // Lock-free while one thread pushes and one drains; head and tail sit on their own cache lines
+    class Ring {
+    public:
+        static constexpr size_t CAPACITY = 4096;  // A power of two
+        bool push(const Record& record);          // False when full
+        size_t size() const;
+        void drainTo(std::vector<Record>& batch);
+    private:
+        Record slots[CAPACITY];
+        alignas(64) std::atomic<size_t> head{0};  // Next record to drain
+        alignas(64) std::atomic<size_t> tail{0};  // Next free slot
+    };
+
+    Ring& threadRing();  // The calling thread's ring, created on its first print
+    void wakeWriter();
+    void run();
+    void writeBatch(std::vector<Record>& batch);
+    static std::string expand(uint16_t message, const std::string& name);  // Message text with %s replaced by name
+    static void appendLine(std::string& buffer, const Record& record, const std::string& text);
+
+    CPUClock* cpuClock;
+    bool singleLog;
+    std::ofstream log;    // Single-log mode only
+    std::ofstream index;  // "<pid> <name> <offset> <records>" per group in the log
+
+    std::mutex ringsMutex;
+    std::vector<std::unique_ptr<Ring>> rings;
+    std::mutex namesMutex;
+    std::unordered_map<size_t, std::string> names;
+
+    // Writer thread only. A record whose predecessor sits in a ring not yet drained waits in
+    // heldBack for a later batch.
+    std::unordered_map<size_t, uint32_t> nextSequence;  // PID -> sequence of its next record to write
+    std::vector<Record> heldBack;
+
+    std::atomic<size_t> nRecords{0};
+    std::atomic<size_t> nBatches{0};
+    std::atomic<size_t> nFullStalls{0};  // Prints that waited for the writer to make room
+
+    std::mutex writerMutex;
+    std::condition_variable writerCondition;
+    std::condition_variable flushedCondition;
+    bool woken = false;
+    bool stopping = false;
+    size_t flushRequests = 0;
+    size_t flushesDone = 0;
+    std::thread writerThread;
+};
+
+#endif // OUTPUT_LOG_H
@@ -4,8 +4,12 @@
 #include <vector>
 #include <iostream>
 #include "IMemoryAllocator.h"
+#include "FrameBitmap.h"
 #include <mutex>
 #include <map>
+#include <unordered_set>
+#include <atomic>
+#include <chrono>
 
 class PagingAllocator : public IMemoryAllocator {
 public:
@@ -18,32 +22,150 @@ public:
     std::map<size_t, std::shared_ptr<Process>>getProcessList()override;
     size_t getMaxMemory()override;
     size_t getExternalFragmentation()override;
-    void deallocateOldest(size_t memSize)override;
+    size_t getLargestFreeBlock()override;
+    size_t getFreeBlockCount()override;
+    bool deallocateOldest(size_t memSize)override;
     size_t getPageIn()override;
     size_t getPageOut()override;
+    size_t getInternalFragmentation()override;
+    void printStats(std::ostream& out)override;
+    int accessPage(Process& process, size_t page)override;
+    size_t getResidentMemory(const Process& process)override;
+    void setReplacementPolicy(std::unique_ptr<ReplacementPolicy> policy)override;
+    BackingStore& getBackingStore()override;
+    void setReclaimWatermarks(int lowPercent, int highPercent)override;
+    bool pin(std::shared_ptr<Process> process)override;
+    void unpin(std::shared_ptr<Process> process)override;
+    size_t getReleaseCount()override;
+    void setReleaseListener(std::function<void()> listener)override;
+    void setFaultCycles(int minorCycles, int majorCycles);
+    void setCoreCount(int nCores);  // One free-frame cache per simulated core
+    void setFramePlacement(const std::string& name);  // "scattered" (demand paging) or "contiguous"
+    void setHugeFrameMultiple(int multiple);  // Base frames per huge frame, 0 or 1 = base frames only
  
 
 
 private:
     size_t maximumSize;          // Total size of the memory pool
     size_t numFrames;
-    std::unordered_map<size_t, std::shared_ptr<Process>> frameMap;
-    std::vector<size_t> freeFrameList;
-    size_t nPagedIn;
-    size_t nPagedOut;
 
-    size_t allocateFrames(size_t numFrames, std::shared_ptr<Process> process);
-    void deallocateFrames(size_t numFrames, size_t frameIndex);
+    struct FrameEntry {
+        Process* owner;  // Null while the frame is free
+        size_t page;     // Virtual page of the owner held in this frame
+        size_t head;     // First frame of the mapping; the replacement policy tracks only this one
+        size_t length;   // Frames in the mapping at its head, 0 for the rest of a huge frame
+    };
+    struct PageEntry {
+        // Resident frame, NO_FRAME when the page is not in memory. Written under memoryMutex and
+        // read without it by the owner's hits.
+        std::atomic<size_t> frame;
+        size_t slot;   // Swap slot holding the evicted contents; a page with neither faults in zero-filled
+
+        PageEntry(size_t frame, size_t slot) : frame(frame), slot(slot) {}
+        PageEntry(const PageEntry& other) : frame(other.frame.load()), slot(other.slot) {}
+        PageEntry& operator=(const PageEntry& other) { frame = other.frame.load(); slot = other.slot; return *this; }
+    };
+    static constexpr size_t NO_FRAME = static_cast<size_t>(-1);
+    std::vector<FrameEntry> frameTable;  // Dense reverse map, indexed by frame number
+    std::unordered_map<size_t, std::vector<PageEntry>> pageTables;  // PID -> entry of each virtual page
+    FrameBitmap freeFrames;  // Frames no core has cached, guarded by freeListMutex
+    bool contiguousPlacement;  // Map every page into one run of frames at allocation when a run is free
+
+    // Hits never take memoryMutex. They set the frame's reference bit and bump their core's hit
+    // count, and sampleReferences hands both to the replacement policy before it decides.
+    std::unique_ptr<std::atomic<uint64_t>[]> referenceBits;  // One bit per frame
+    size_t nReferenceWords;
+    std::atomic<size_t> nUncachedHits{0};  // Hits of processes on no known core
+    size_t nSampledHits = 0;               // Hits already added to the policy, under memoryMutex
+
+    // A huge frame is hugeFrameMultiple aligned base frames mapped, faulted and evicted as one.
+    // Processes spanning at least one huge frame fault a whole aligned group of pages in at once
+    // when such a run is free, and fall back to base frames when it is not.
+    size_t hugeFrameMultiple;
+    bool backedByHugeFrames(const Process& process) const;
+    size_t internalFragmentation(const Process& process) const;  // KB past the process's memory in its last page
+    enum SizeClass { BASE_FRAME, HUGE_FRAME, NUM_SIZE_CLASSES };
+    struct SizeClassStats {
+        std::atomic<size_t> pageTableEntries{0};       // Entries live page tables need at this size
+        std::atomic<size_t> internalFragmentation{0};  // KB mapped or reserved but never used
+        std::atomic<size_t> pagedIn{0};
+        std::atomic<size_t> pagedOut{0};
+    };
+    SizeClassStats sizeClassStats[NUM_SIZE_CLASSES];
+    std::atomic<size_t> nHugeFallbacks{0};  // Huge-backed faults served by a base frame
+
+    // Free frames owned by one core. A fault takes from its core's cache, which refills from and
+    // drains to freeFrames a batch at a time, so the shared set is touched once per batch.
+    // Faults take their frame before memoryMutex, so their cache traffic never happens under it.
+    struct FrameCache {
+        std::mutex mutex;  // Taken before freeListMutex, never after it; at most one cache at a time
+        std::vector<size_t> frames;
+        std::atomic<size_t> hits{0};  // Only the core's own worker writes it
+    };
+    static constexpr size_t FRAME_CACHE_BATCH = 8;
+    std::vector<std::unique_ptr<FrameCache>> frameCaches;  // Indexed by core ID; core IDs start at 1, so index 0 stays idle
+    std::mutex freeListMutex;
+
+    // Statistics are atomic so monitoring commands read them without memoryMutex
+    std::atomic<size_t> nFreeFrames;  // freeFrames plus every cache
+    std::atomic<size_t> nFramesInTransit{0};  // Neither free nor resident: taken for a fault, or unmapped and not yet put back
+    std::atomic<size_t> nPagedIn;
+    std::atomic<size_t> nPagedOut;
+    std::atomic<size_t> nMinorFaults;
+    std::atomic<size_t> nMajorFaults;
+    std::atomic<size_t> nFaultCycles;
+    std::atomic<size_t> nCacheRefills{0};
+    std::atomic<size_t> nCacheDrains{0};
+    std::atomic<size_t> nContiguousAllocations{0};
+    std::atomic<size_t> nLockAcquisitions{0};
+    std::atomic<size_t> nContendedAcquisitions{0};
+    std::atomic<size_t> lockWaitNanos{0};  // Time spent blocked on memoryMutex
+    std::atomic<size_t> lockHoldNanos{0};  // Time memoryMutex was held
+
+    // Locks memoryMutex and adds the wait and hold times to the statistics; the wait is only
+    // timed when the mutex was already taken
+    class TimedLock {
+    public:
+        explicit TimedLock(PagingAllocator& allocator);
+        ~TimedLock();
+    private:
+        PagingAllocator& allocator;
+        std::chrono::steady_clock::time_point acquired;
+    };
+    int minorFaultCycles;
+    int majorFaultCycles;
+
+    int fault(Process& process, std::vector<PageEntry>& pageTable, size_t page);  // Maps the page, returns the fault cycles
+    void countHit(int core);
+    void sampleReferences();  // Passes hits and reference bits to the policy, lock held
+    size_t takeFrame(int core);  // A free frame, evicting a resident page if there is none; NO_FRAME if neither; lock held
+    // A frame taken for a fault is in transit until mapped, so conservation holds while the
+    // fault holds it outside memoryMutex
+    size_t takeFreeFrame(int core);  // From the core's cache, the shared list or another cache; NO_FRAME if none is free
+    void putFreeFrame(int core, size_t frameIndex);  // A core of -1 returns the frame to the shared set
+    bool mapContiguous(Process& process, std::vector<PageEntry>& pageTable);  // False when no run is free
+    bool mapHugeFrame(Process& process, std::vector<PageEntry>& pageTable, size_t page, bool& major);  // False when no aligned run is free
+    void freeMapping(size_t head, size_t length);  // Returns every frame after the head to the shared set
+    // Free, cached, resident and in-transit frames must add up to numFrames. Asserted after every
+    // allocation, release and reclaim in debug builds, and checked by printStats in all builds.
+    bool checkFrameConservation();
+    size_t swapOutMapping(size_t head);  // Writes the mapping's pages to the backing store, returns its length
+    bool reclaimFrame();         // Background eviction of one frame, false when none is resident
+    void releaseFrames(std::vector<PageEntry>& pageTable, int core);  // Base frames go to the core's cache
 
 
     size_t mem_per_frame;
     size_t allocatedSize;        // Currently allocated size
-    std::vector<char> memory;    // Memory pool representation
+    std::vector<char> memory;    // Frame contents, one byte per KB
     std::vector<bool> allocationMap;  // Allocation tracking map
-    int nProcess;
+    std::atomic<int> nProcess;
 
-    std::mutex memoryMutex;
+    std::mutex memoryMutex;  // Guards the frame table and page table mappings; hits do not take it
+    std::unordered_set<size_t> pinnedProcesses;  // PIDs dispatched on a core, never chosen to lose every page
+    BackingStore backingStore;
+    std::unique_ptr<ReplacementPolicy> replacementPolicy;  // Tracks resident frames
     std::map<size_t, std::shared_ptr<Process>> processList; //index of starting memory, name, size
+    MemoryReclaimer reclaimer;  // Declared last so its thread stops before the rest is destroyed
 };
 
-#endif // FLAT_MEMORY_ALLOCATOR_H
+#endif // PAGING_ALLOCATOR_H
@@ -1,14 +1,19 @@
 #ifndef PROCESS_H
 #define PROCESS_H
 
-#include "ICommand.h"
-#include "PrintCommand.h"
+#include "InstructionSource.h"
 
 #include <memory>
 #include <string>
 #include <vector>
 #include <ctime>
+#include <chrono>
 #include <cmath>
+#include <random>
+#include <atomic>
+
+class IMemoryAllocator; // Forward declaration
+class OutputLog;
 
 class Process
 {
@@ -32,8 +37,20 @@ public:
     // Constructor
     Process(int pid, const std::string &name, const std::string &time, int core, int minIns, int maxIns, size_t mem_per_proc, size_t mem_per_frame);
 
-    // Method to execute the current command
-    void executeCurrentCommand();
+    // Pages an instruction may touch under demand paging
+    enum PageAccessPattern
+    {
+        SEQUENTIAL,  // Walks the address space from first to last page over the program
+        RANDOM,      // Any page, uniformly
+        LOCALITY     // Mostly the current page, with occasional jumps
+    };
+
+    // Method to execute the current command; returns the page fault cycles it stalled for
+    int executeCurrentCommand(int& waitTicks);
+
+    // Executes up to count commands back to back and returns how many ran. SLEEP and IO end
+    // the burst and add the ticks the process must wait off its core to waitTicks.
+    int executeCommands(int count, int& stallCycles, int& waitTicks);
 
     // Getters
     int getCommandCounter() const;
@@ -50,17 +67,52 @@ public:
     void* getMemory() const;
     void setAllocTime();
     std::chrono::time_point<std::chrono::system_clock> getAllocTime();
-    size_t getNumPages();
+    size_t getNumPages() const;
     void calculateFrame();
 
-    // Method to generate print commands
-    void generate_commands(int minIns, int maxIns);
+    void setOutputLog(OutputLog* log);  // Where PRINT goes; without one PRINT only reads its operands
+
+    // Demand paging
+    void setMemoryAllocator(IMemoryAllocator* allocator);
+    void setPageAccessPattern(const std::string& pattern);
+    void recordPageFault(bool major, int cycles);
+    void adjustResidentPages(int delta);
+    size_t getResidentPages() const;
+    size_t getMinorFaults() const;
+    size_t getMajorFaults() const;
+    size_t getFaultCycles() const;
+
+    // Swap images of contiguous allocators carry the interpreter state, which the process does
+    // not hold while it is swapped out. Images are getExecutionImageSize() bytes.
+    static size_t getExecutionImageSize();
+    void swapOutExecution(char* image);
+    void swapInExecution(const char* image);
+
+    // Picks the length and seed of the instruction stream; instructions are generated as they run.
+    // blockingPercent of the statements are SLEEP or IO.
+    void generate_commands(int minIns, int maxIns, int blockingPercent);
+    size_t getProgramFootprint() const;  // Bytes of generated instructions still held
 
 private:
     size_t Pid;
     std::string Name;
     std::string Time;
-    std::vector<std::shared_ptr<ICommand>> CommandList;
+    InstructionSource instructions;  // Holds no instructions until the process first runs
+
+    // Interpreter state, created when the process first runs and dropped when it finishes.
+    // The allocators model which pages are resident rather than their contents, so the
+    // symbol table at the base of the process's memory is kept here.
+    struct ExecutionState {
+        uint16_t variables[Program::VARIABLE_COUNT] = {};
+        struct Loop {
+            size_t bodyStart;
+            uint16_t remaining;
+        } loops[Program::MAX_LOOP_DEPTH];
+        int loopDepth = 0;
+        size_t pc = 0;  // Next instruction of the current block
+    };
+    std::unique_ptr<ExecutionState> execution;
+    std::atomic<size_t> programFootprint{0};  // Read by monitoring threads while a core generates or releases blocks
     std::chrono::time_point<std::chrono::system_clock> allocationTime;  // Use chrono for allocation time
 
 
@@ -72,6 +124,18 @@ private:
     RequirementFlags requirementFlags;
     ProcessState processState;
     void* memory;
+
+    int touchPage();  // Touches the page of the current command, returns fault cycles
+    IMemoryAllocator* memoryAllocator = nullptr;
+    OutputLog* outputLog = nullptr;
+    uint32_t nPrints = 0;  // Sequence number of the next PRINT, which keeps its lines in order across cores
+    PageAccessPattern accessPattern = LOCALITY;
+    std::minstd_rand pageRng;
+    size_t currentPage = 0;
+    size_t residentPages = 0;
+    size_t minorFaults = 0;
+    size_t majorFaults = 0;
+    size_t faultCycles = 0;
 };
 
 #endif // PROCESS_H
@@ -4,8 +4,11 @@
 #include "Process.h"
 #include "Scheduler.h"
 #include "CPUClock.h"
+#include "ConfigOptions.h"
 #include "FlatMemoryAllocator.h"
 #include "PagingAllocator.h"
+#include "BuddyMemoryAllocator.h"
+#include "OutputLog.h"
 
 
 #include <map>
@@ -31,7 +34,10 @@ private:
     size_t max_mem_per_proc;
     size_t max_mem; 
     size_t mem_per_frame;
+    std::string page_access;
+    int blocking_percent;
     IMemoryAllocator* memoryAllocator;
+    OutputLog* outputLog = nullptr;  // Null when process output is off
     int nCPU;
     std::mutex processListMutex;
     std::mutex coreStatesMutex;
@@ -39,7 +45,7 @@ private:
     
 public:
     ProcessManager(int Min_ins, int Max_ins, int nCPU, std::string SchedulerAlgo, int delays_per_exec, int quantum_cycle, CPUClock* CpuClock
-        , size_t max_mem, size_t mem_per_frame, size_t min_mem_per_proc, size_t max_mem_per_proc);
+        , size_t max_mem, size_t mem_per_frame, size_t min_mem_per_proc, size_t max_mem_per_proc, const ConfigOptions& options);
     void addProcess(string name, string time);
     shared_ptr<Process> getProcess(string name);
     map<string, std::shared_ptr<Process>> getAllProcess();
@@ -52,6 +58,7 @@ public:
     }
     void process_smi();
     void vmstat();
+    void flushOutput();  // Writes out every PRINT record still queued
 
 };
 
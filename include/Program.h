@@ -0,0 +1,69 @@
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Instructions of one process as a flat array of fixed-size records. Text operands are
+// indices into a string table shared by every program, so each distinct string is stored
+// once and stays valid for output written after the program is gone.
+class Program {
+public:
+    enum Opcode : uint8_t {
+        DECLARE,   // variable a = b
+        ADD,       // variable a = b + c, saturating at 65535
+        SUBTRACT,  // variable a = b - c, saturating at 0
+        PRINT,     // string a, with %s standing for the process name; with HAS_B, followed by the value of b
+        SLEEP,     // a ticks off the core
+        IO,        // Waits a ticks off the core for a simulated device
+        FOR,       // Runs the instructions up to the matching END a times
+        END
+    };
+
+    // Operand b and c name variables unless their LITERAL flag is set
+    enum Flags : uint8_t {
+        LITERAL_B = 1,
+        LITERAL_C = 2,
+        HAS_B = 4
+    };
+
+    static constexpr int VARIABLE_COUNT = 32;  // uint16 variables, a 64-byte symbol table; a power of two so operands can be masked
+    static constexpr int MAX_LOOP_DEPTH = 3;
+
+    struct Instruction {
+        Opcode opcode;
+        uint8_t flags;
+        uint16_t a;
+        uint16_t b;
+        uint16_t c;
+    };
+
+    static uint16_t intern(const std::string& text);  // Index of text in the string table, added if new
+    static const std::string& getString(uint16_t index);  // Safe from any thread; strings never move
+    void reserve(size_t count);
+    void reset();  // Drops the instructions but keeps their storage
+    void clear();  // Gives back the instruction storage
+
+    // Defined here so the generator and the interpreter loop can inline them
+    void emit(Opcode opcode, uint16_t a = 0, uint16_t b = 0, uint16_t c = 0, uint8_t flags = 0)
+    {
+        // Filled in place: a record built on the stack and copied stalls on store forwarding
+        Instruction& instruction = code.emplace_back();
+        instruction.opcode = opcode;
+        instruction.flags = flags;
+        instruction.a = a;
+        instruction.b = b;
+        instruction.c = c;
+    }
+    size_t size() const { return code.size(); }
+    const Instruction& operator[](size_t index) const { return code[index]; }
+
+    size_t getFootprint() const;  // Bytes held by the instructions
+
+private:
+    std::vector<Instruction> code;
+};
+
+#endif // PROGRAM_H
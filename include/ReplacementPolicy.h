@@ -0,0 +1,112 @@
+#ifndef REPLACEMENT_POLICY_H
+#define REPLACEMENT_POLICY_H
+
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Chooses which resident unit to evict. Allocators decide what a unit is (a frame for
+// paging, a block for contiguous allocators) and call this under their own lock.
+class ReplacementPolicy {
+public:
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+    using Eligible = std::function<bool(size_t)>;  // Filters victims, an empty filter accepts every unit
+
+    virtual ~ReplacementPolicy() = default;
+    virtual const char* getName() const = 0;
+
+    void load(size_t id);     // id became resident (a miss)
+    void hit(size_t id);      // id was referenced while resident
+    void reference(size_t id);   // A sampled reference bit of id was set; the owner counts the hits behind it
+    void addHits(size_t count);  // Hits the owner counted without telling the policy which unit they hit
+    void release(size_t id);  // id left memory on its own, ids not tracked are ignored
+    void relocate(size_t from, size_t to);  // The unit was renamed, e.g. moved by compaction; keeps its place
+    size_t evict(const Eligible& eligible = nullptr);  // Chooses and forgets a victim, NONE when nothing qualifies
+
+    void printStats(std::ostream& out) const;
+
+protected:
+    virtual void onLoad(size_t id) = 0;
+    virtual void onHit(size_t id) = 0;
+    virtual void onRelease(size_t id) = 0;
+    virtual void onRelocate(size_t from, size_t to) = 0;
+    virtual size_t selectVictim(const Eligible& eligible) = 0;
+    static bool accepts(const Eligible& eligible, size_t id) { return !eligible || eligible(id); }
+
+private:
+    size_t nHits = 0;
+    size_t nMisses = 0;
+    size_t nEvictions = 0;
+};
+
+// Evicts in load order
+class FifoPolicy : public ReplacementPolicy {
+public:
+    const char* getName() const override { return "fifo"; }
+
+protected:
+    void onLoad(size_t id) override;
+    void onHit(size_t id) override;
+    void onRelease(size_t id) override;
+    void onRelocate(size_t from, size_t to) override;
+    size_t selectVictim(const Eligible& eligible) override;
+
+    std::list<size_t> order;  // Front is the next victim
+    std::unordered_map<size_t, std::list<size_t>::iterator> position;
+};
+
+// Evicts the least recently referenced unit; a hit moves the unit to the back
+class LruPolicy : public FifoPolicy {
+public:
+    const char* getName() const override { return "lru"; }
+
+protected:
+    void onHit(size_t id) override;
+};
+
+// Second chance: the hand clears reference bits and evicts the first unit without one
+class ClockPolicy : public ReplacementPolicy {
+public:
+    const char* getName() const override { return "clock"; }
+
+protected:
+    struct Entry {
+        size_t id;
+        bool referenced;
+        size_t lastUse;  // Value of now at the unit's last reference
+    };
+
+    void onLoad(size_t id) override;
+    void onHit(size_t id) override;
+    void onRelease(size_t id) override;
+    void onRelocate(size_t from, size_t to) override;
+    size_t selectVictim(const Eligible& eligible) override;
+    size_t take(std::list<Entry>::iterator it);  // Forgets it and returns its id, keeping the hand valid
+
+    std::list<Entry> ring;
+    std::list<Entry>::iterator hand = ring.end();
+    std::unordered_map<size_t, std::list<Entry>::iterator> position;
+    size_t now = 0;  // References seen so far, the policy's notion of time
+};
+
+// WSClock: like CLOCK, but only units unused for longer than the window are evicted
+// while any exist; the oldest unreferenced unit goes when everything is in the working set
+class WorkingSetPolicy : public ClockPolicy {
+public:
+    explicit WorkingSetPolicy(size_t window);
+    const char* getName() const override { return "working-set"; }
+
+protected:
+    size_t selectVictim(const Eligible& eligible) override;
+
+private:
+    size_t window;
+};
+
+// "fifo", "lru", "clock" (or "second-chance") and "working-set"; unknown names fall back to fifo
+std::unique_ptr<ReplacementPolicy> createReplacementPolicy(const std::string& name, size_t workingSetWindow);
+
+#endif // REPLACEMENT_POLICY_H
@@ -0,0 +1,60 @@
+#ifndef RESIDENT_BLOCKS_H
+#define RESIDENT_BLOCKS_H
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "BackingStore.h"
+#include "ReplacementPolicy.h"
+
+class Process;
+
+// Residency bookkeeping shared by the contiguous allocators, which keep or evict a
+// process's block as a whole: the replacement order of resident blocks, which of them
+// are pinned to a core, and the swap images of evicted processes. Blocks are named by
+// their offset in the pool. A pool pointer of nullptr means the allocator keeps no
+// contents, so images hold only the interpreter state. Not thread-safe; every call but
+// getReleaseCount and notifyRelease is made with the owning allocator's lock held.
+class ResidentBlocks {
+public:
+    explicit ResidentBlocks(BackingStore& backingStore);
+
+    void setPolicy(std::unique_ptr<ReplacementPolicy> policy);
+    void printStats(std::ostream& out) const;
+
+    // A block was placed for process, which resumes from its swap image if it has one and
+    // gets handle as its memory. The process is dispatched right after, so the block starts
+    // out pinned.
+    void load(size_t block, Process& process, void* handle, char* pool);
+    void release(size_t block, Process& process);  // Freed on exit or after swapOutVictim
+    void relocate(size_t from, size_t to);         // Compaction moved the block
+
+    void pin(size_t block, const Process& process);  // Dispatched; counts as one reference to the block
+    void unpin(const Process& process);
+    bool isPinned(const Process& process) const;
+
+    // Saves the image of the policy's unpinned victim among processList and returns its
+    // block, which the caller then frees; ReplacementPolicy::NONE if every block is pinned
+    size_t swapOutVictim(const std::map<size_t, std::shared_ptr<Process>>& processList, const char* pool, size_t& nSlots);
+
+    // Every unpin and release moves the count; the allocator calls notifyRelease after an
+    // unpin or free once its lock is released
+    size_t getReleaseCount() const;
+    void setReleaseListener(std::function<void()> listener);
+    void notifyRelease() const;
+
+private:
+    BackingStore& backingStore;
+    std::unique_ptr<ReplacementPolicy> policy;
+    std::unordered_set<size_t> pinnedProcesses;                  // PIDs dispatched on a core, never chosen as victims
+    std::unordered_map<size_t, std::vector<size_t>> swapRecords;  // PID -> swap slots of its saved image
+    std::atomic<size_t> nReleases{0};
+    std::function<void()> releaseListener;  // Set before the scheduler starts
+};
+
+#endif // RESIDENT_BLOCKS_H
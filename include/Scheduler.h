@@ -2,8 +2,10 @@
 #define SCHEDULER_H
 #include "CPUClock.h"
 #include "FlatMemoryAllocator.h"
+#include "TimerWheel.h"
 
-#include <queue>
+#include <deque>
+#include <atomic>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -27,13 +29,70 @@ public:
     void start();
     void stop();
     void setCPUClock(CPUClock* cpuClock); 
+    void setExecutionMode(const std::string& mode, int hostThreads);
+    void setContextSwitchCycles(int cycles);
+    size_t getSteals() const;
+    size_t getMigrations() const;
+    size_t getInstructionsExecuted() const;
+    size_t getWaitingProcesses() const;  // Blocked on SLEEP or IO
+    size_t getBlockingWaits() const;     // SLEEP and IO waits since start
 
 private:
-    void run(int coreID);
-    void scheduleFCFS(int coreID);
-    void scheduleRR(int coreID);
+    // Per-core ready queue; idle cores steal from the back of other cores' queues
+    struct RunQueue {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<Process>> processes;
+    };
+
+    // Resumable state of one simulated core, stepped by whichever worker owns it
+    struct CoreContext {
+        enum Phase { IDLE, DISPATCH, EXECUTE, SWITCH };
+
+        int coreID = 0;
+        Phase phase = IDLE;
+        std::shared_ptr<Process> process;
+        int runCore = -1;       // Core the process is shown on (FCFS takes the first free one)
+        int wakeTick = 0;       // Tick at which the core continues
+        int waitUntil = 0;      // Wake tick of a process leaving the core to wait, 0 if it is not waiting
+        int quantum = 0;
+        int cycleCounter = 0;
+        bool firstCommandExecuted = false;
+        bool waitingForMemory = false;   // Parked in DISPATCH until the allocator releases a pinned process
+        std::atomic<bool> memoryReleased{false};  // Set by wakeMemoryWaiters under queueMutex
+        std::atomic<size_t> instructions{0};  // Executed on this core; only its worker writes it
+    };
+
+    // Host thread driving a fixed set of cores
+    struct Worker {
+        int slot = -1;              // Clock participant slot
+        bool participating = false;
+        std::vector<CoreContext*> cores;
+        std::condition_variable* sleepingOn = nullptr;  // Set while in waitForWork, under queueMutex
+        bool heldJoin = false;  // A release held the virtual tick for this sleeping worker, under queueMutex
+    };
+
+    void run(int workerID);
+    void stepCore(Worker& worker, CoreContext& core, int tick);
+    bool dispatchProcess(Worker& worker, CoreContext& core, int tick);
+    void executeFCFS(CoreContext& core, int tick);
+    void executeRR(CoreContext& core, int tick);
+    void beginWait(CoreContext& core, int tick, int stallCycles, int waitTicks);
+    void finishQuantum(CoreContext& core, int tick);
+    void sleepProcess(std::shared_ptr<Process> process, int wakeTick);
+    void wakeSleepers(int tick);
+    void joinClock(Worker& worker);
+    void leaveClock(Worker& worker);
     void logMemoryState(int n);
     void startMemoryLog();
+    void waitForWork(std::unique_lock<std::mutex>& lock, Worker& worker);
+    bool hasWork(const Worker& worker, bool canTakeWork) const;
+    void waitForMemory(Worker& worker, CoreContext& core, size_t releases);
+    void wakeMemoryWaiters();
+    void createRunQueues();
+    size_t pushProcess(int coreID, std::shared_ptr<Process> process);
+    void wakeIdleCore();
+    std::shared_ptr<Process> popProcess(int coreID);
+    void recordDispatch(std::shared_ptr<Process> process, int coreID);
 
     bool memoryLog = false;
     bool running;
@@ -41,13 +100,35 @@ private:
     int nCPU;
     int delay_per_exec;
     int quantum_cycle;
+    int contextSwitchCycles = 2;
     int readyThreads;
+    int idleCores = 0;      // Workers sleeping on queueCondition
+    // Cores parked because every resident process is pinned, with their workers. The allocator's
+    // next unpin or free releases all of them to retry. Guarded by queueMutex.
+    std::vector<std::pair<Worker*, CoreContext*>> memoryWaiters;
+    std::atomic<size_t> nMemoryWaiters{0};  // Read without the lock on every release
+    int wakeTokens = 0;     // Clock participations handed to cores being woken
     std::string schedulerAlgo;
-    std::queue<std::shared_ptr<Process>> processQueue;
+    std::string execMode = "threads";
+    int hostThreadCount = 0;
+    std::vector<std::unique_ptr<RunQueue>> runQueues;
+    std::atomic<int> queuedProcesses{0};
+    std::atomic<size_t> nextQueue{0};
+    std::atomic<size_t> steals{0};
+    std::atomic<size_t> migrations{0};
+    // Processes blocked on SLEEP or IO; whichever worker first reaches a wake tick moves them to the run queues
+    TimerWheel sleepers;
+    std::mutex sleepersMutex;
+    std::atomic<int> nextSleeperWake{TimerWheel::NO_WAKE};  // Read without the lock on every tick
+    std::atomic<size_t> waitingProcesses{0};
+    std::atomic<size_t> blockingWaits{0};
     std::vector<std::thread> workerThreads;
+    std::vector<std::unique_ptr<CoreContext>> cores;   // Indexed by core ID
+    std::vector<std::unique_ptr<Worker>> workers;
     std::mutex queueMutex;
     std::mutex activeThreadsMutex;
     std::condition_variable queueCondition;
+    std::condition_variable memoryCondition;  // Workers with no idle core and a core parked for memory
     std::mutex startMutex;
     std::mutex logMutex;
     std::condition_variable startCondition;
@@ -0,0 +1,41 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <climits>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+class Process;
+
+// Processes blocked until a tick, hashed by wake tick into a ring of slots. Scheduling
+// is O(1), and expiring a tick only looks at that tick's slot, so the cost of a tick is
+// the number of processes due rather than the number waiting. Waits longer than the
+// ring stay in their slot until the round they are due. Not thread-safe.
+class TimerWheel {
+public:
+    static constexpr int NO_WAKE = INT_MAX;
+
+    explicit TimerWheel(size_t nSlots = 256);
+
+    void schedule(int wakeTick, std::shared_ptr<Process> process);
+    void expire(int tick, std::vector<std::shared_ptr<Process>>& due);  // Moves every process due at or before tick into due
+    int nextWake() const;  // Earliest wake tick, NO_WAKE when nothing waits
+    size_t size() const;
+
+private:
+    struct Timer {
+        int wakeTick;
+        std::shared_ptr<Process> process;
+    };
+
+    std::vector<Timer>& slotOf(int tick);
+    void findNextWake(int after);
+
+    std::vector<std::vector<Timer>> slots;
+    int lastTick = -1;  // Every tick up to this one has been expired
+    int earliest = NO_WAKE;
+    size_t count = 0;
+};
+
+#endif // TIMER_WHEEL_H
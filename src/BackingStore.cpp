@@ -0,0 +1,280 @@
+#include "../include/BackingStore.h"
+#include "../include/Process.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+BackingStore::BackingStore(const std::string& path, size_t slotBytes, size_t initialSlots)
+    : path(path), slotBytes(std::max<size_t>(slotBytes, 1))
+{
+    file.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Unable to open the swap file: " << path << std::endl;
+    }
+    grow(std::max<size_t>(initialSlots, 1));
+    daemonThread = std::thread(&BackingStore::runDaemon, this);
+}
+
+BackingStore::~BackingStore()
+{
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        stopping = true;
+    }
+    workCondition.notify_all();
+    if (daemonThread.joinable()) {
+        daemonThread.join();
+    }
+}
+
+void BackingStore::grow(size_t slots)
+{
+    size_t oldCapacity = capacity;
+    capacity += slots;
+
+    // Touch the last byte so the whole range exists on disk up front
+    {
+        std::lock_guard<std::mutex> fileLock(fileMutex);
+        file.clear();
+        file.seekp(static_cast<std::streamoff>(capacity * slotBytes - 1));
+        file.put('\0');
+        file.flush();
+    }
+
+    // Lowest slots are handed out first
+    for (size_t slot = capacity; slot-- > oldCapacity;) {
+        freeSlots.push_back(slot);
+    }
+}
+
+std::vector<size_t> BackingStore::write(const char* data, size_t bytes)
+{
+    std::unique_lock<std::mutex> lock(storeMutex);
+    size_t needed = std::max<size_t>((bytes + slotBytes - 1) / slotBytes, 1);
+
+    // Back-pressure: wait for the daemon when the queue is full, unless it is empty
+    spaceCondition.wait(lock, [&] { return pending.empty() || pending.size() + needed <= queueLimit; });
+
+    if (freeSlots.size() < needed) {
+        grow(std::max(capacity, needed));
+    }
+
+    std::vector<size_t> slots;
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < needed; ++i) {
+        size_t slot = freeSlots.back();
+        freeSlots.pop_back();
+        slots.push_back(slot);
+
+        size_t offset = i * slotBytes;
+        size_t chunk = std::min(slotBytes, bytes - std::min(bytes, offset));
+        PendingWrite& entry = pending[slot];
+        entry.data.assign(data + offset, data + offset + chunk);
+        entry.data.resize(slotBytes, 0);
+        entry.version = nextVersion++;
+        entry.queued = now;
+        writeQueue.push_back(slot);
+    }
+    maxQueueDepth = std::max(maxQueueDepth, pending.size());
+    lock.unlock();
+    workCondition.notify_one();
+    return slots;
+}
+
+void BackingStore::read(const std::vector<size_t>& slots, char* data, size_t bytes)
+{
+    // Slots still waiting for the daemon are served from the queue
+    std::vector<size_t> fromFile;
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        for (size_t i = 0; i < slots.size(); ++i) {
+            size_t offset = i * slotBytes;
+            size_t chunk = std::min(slotBytes, bytes - std::min(bytes, offset));
+            auto it = pending.find(slots[i]);
+            if (it != pending.end()) {
+                std::memcpy(data + offset, it->second.data.data(), chunk);
+            } else {
+                fromFile.push_back(i);
+            }
+        }
+        bytesRead += bytes;
+    }
+
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    file.clear();
+    for (size_t i : fromFile) {
+        size_t offset = i * slotBytes;
+        size_t chunk = std::min(slotBytes, bytes - std::min(bytes, offset));
+        file.seekg(static_cast<std::streamoff>(slots[i] * slotBytes));
+        file.read(data + offset, static_cast<std::streamsize>(chunk));
+    }
+}
+
+void BackingStore::release(const std::vector<size_t>& slots)
+{
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        for (size_t slot : slots) {
+            pending.erase(slot);  // No point writing contents nobody will read
+        }
+        freeSlots.insert(freeSlots.end(), slots.begin(), slots.end());
+    }
+    spaceCondition.notify_all();
+}
+
+void BackingStore::runDaemon()
+{
+    struct Flush {
+        size_t slot;
+        size_t version;
+        std::vector<char> data;
+    };
+
+    std::unique_lock<std::mutex> lock(storeMutex);
+    for (;;) {
+        workCondition.wait(lock, [this] { return stopping || !writeQueue.empty(); });
+        if (writeQueue.empty()) {
+            return;  // Stopping with everything flushed
+        }
+
+        // Take everything queued so far as one batch; released or rewritten slots are skipped
+        std::vector<Flush> batch;
+        while (!writeQueue.empty()) {
+            size_t slot = writeQueue.front();
+            writeQueue.pop_front();
+            auto it = pending.find(slot);
+            if (it != pending.end()) {
+                batch.push_back(Flush{slot, it->second.version, it->second.data});
+            }
+        }
+        lock.unlock();
+
+        // Sorted by slot the batch becomes mostly sequential file writes
+        std::sort(batch.begin(), batch.end(), [](const Flush& a, const Flush& b) { return a.slot < b.slot; });
+        batch.erase(std::unique(batch.begin(), batch.end(), [](const Flush& a, const Flush& b) { return a.slot == b.slot; }), batch.end());
+        {
+            std::lock_guard<std::mutex> fileLock(fileMutex);
+            file.clear();
+            for (const Flush& flush : batch) {
+                file.seekp(static_cast<std::streamoff>(flush.slot * slotBytes));
+                file.write(flush.data.data(), static_cast<std::streamsize>(slotBytes));
+            }
+            file.flush();
+        }
+
+        lock.lock();
+        auto now = std::chrono::steady_clock::now();
+        for (const Flush& flush : batch) {
+            auto it = pending.find(flush.slot);
+            if (it != pending.end() && it->second.version == flush.version) {
+                totalWriteLatencyUs += std::chrono::duration<double, std::micro>(now - it->second.queued).count();
+                pending.erase(it);
+                nFlushedWrites++;
+            }
+            bytesWritten += slotBytes;
+        }
+        nBatches++;
+        spaceCondition.notify_all();
+    }
+}
+
+std::vector<size_t> BackingStore::swapOutProcess(Process& process, const char* memory, size_t bytes)
+{
+    ProcessHeader header{process.getPID()};
+    size_t stateBytes = Process::getExecutionImageSize();
+    std::vector<char> image(sizeof(header) + stateBytes + bytes);
+    std::memcpy(image.data(), &header, sizeof(header));
+    process.swapOutExecution(image.data() + sizeof(header));
+    if (bytes > 0) {
+        std::memcpy(image.data() + sizeof(header) + stateBytes, memory, bytes);
+    }
+    return write(image.data(), image.size());
+}
+
+void BackingStore::swapInProcess(Process& process, const std::vector<size_t>& slots, char* memory, size_t bytes)
+{
+    size_t stateBytes = Process::getExecutionImageSize();
+    std::vector<char> image(sizeof(ProcessHeader) + stateBytes + bytes);
+    read(slots, image.data(), image.size());
+
+    ProcessHeader header;
+    std::memcpy(&header, image.data(), sizeof(header));
+    if (header.pid == process.getPID()) {
+        process.swapInExecution(image.data() + sizeof(header));
+        if (bytes > 0) {
+            std::memcpy(memory, image.data() + sizeof(header) + stateBytes, bytes);
+        }
+    } else {
+        std::cerr << "Error: Swap image of process " << header.pid << " read for process " << process.getPID() << std::endl;
+    }
+}
+
+void BackingStore::setQueueLimit(size_t slots)
+{
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        queueLimit = std::max<size_t>(slots, 1);
+    }
+    spaceCondition.notify_all();
+}
+
+void BackingStore::setDebugLog(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(storeMutex);
+    debugLog = enabled;
+}
+
+void BackingStore::logSwapOut(Process& process, const std::string& detail)
+{
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        if (!debugLog) {
+            return;
+        }
+    }
+
+    std::ofstream backingStore("backingstore.txt", std::ios::app);  // Open file in append mode
+    if (backingStore.is_open()) {
+        backingStore << "Process ID: " << process.getPID();
+        backingStore << "  Name: " << process.getName();
+        backingStore << "  Command Counter: " << process.getCommandCounter()
+            << "/" << process.getLinesOfCode() << "\n";
+        backingStore << "Memory Size: " << process.getMemoryRequired() << " KB\n";
+        backingStore << "Num Pages: " << process.getNumPages() << "\n";
+        backingStore << detail << "\n";
+        backingStore << "============================================================================\n";
+    }
+}
+
+size_t BackingStore::getSlotBytes() const
+{
+    return slotBytes;
+}
+
+size_t BackingStore::getBytesWritten()
+{
+    std::lock_guard<std::mutex> lock(storeMutex);
+    return bytesWritten;
+}
+
+size_t BackingStore::getBytesRead()
+{
+    std::lock_guard<std::mutex> lock(storeMutex);
+    return bytesRead;
+}
+
+void BackingStore::printStats(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(storeMutex);
+    out << std::setw(12) << bytesWritten << " bytes written to swap" << std::endl;
+    out << std::setw(12) << bytesRead << " bytes read from swap" << std::endl;
+    out << std::setw(12) << capacity - freeSlots.size() << " swap slots in use" << std::endl;
+    std::ostringstream latency;
+    latency << std::fixed << std::setprecision(2) << (nFlushedWrites ? totalWriteLatencyUs / nFlushedWrites : 0.0);
+    out << std::setw(12) << pending.size() << " swap queue depth" << std::endl;
+    out << std::setw(12) << maxQueueDepth << " swap queue peak depth" << std::endl;
+    out << std::setw(12) << nBatches << " swap write batches" << std::endl;
+    out << std::setw(12) << latency.str() << " us avg swap write latency" << std::endl;
+}
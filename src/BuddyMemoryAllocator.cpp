@@ -0,0 +1,274 @@
+#include "../include/BuddyMemoryAllocator.h"
+#include "../include/Process.h"
+#include <iostream> 
+#include <fstream>  
+#include <ctime>  
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <algorithm>
+
+BuddyMemoryAllocator::BuddyMemoryAllocator(size_t maximumSize, size_t mem_per_frame) 
+    : maximumSize(maximumSize), mem_per_frame(mem_per_frame), maxOrder(0), freeSize(maximumSize), largestFree(0), nFreeBlocks(0),
+      internalFragmentation(0), nSplits(0), nCoalesces(0), memory(maximumSize, '.'), nProcess(0),
+      backingStore("backingstore.bin", mem_per_frame, maximumSize / std::max<size_t>(mem_per_frame, 1)), residentBlocks(backingStore),
+      reclaimer([this] { return freeSize.load(); },
+                [this] { return evictVictim(); }) {
+    while ((size_t(2) << maxOrder) <= maximumSize) {
+        maxOrder++;
+    }
+    freeLists.resize(maxOrder + 1);
+
+    // A pool that is not a power of two is covered by descending power-of-two
+    // blocks; each one starts at a multiple of its own size, so buddy offsets
+    // stay valid and no merge can cross the end of the pool.
+    size_t index = 0;
+    for (size_t order = maxOrder + 1; order-- > 0;) {
+        size_t blockSize = size_t(1) << order;
+        if (index + blockSize <= maximumSize) {
+            freeLists[order].insert(index);
+            nFreeBlocks++;
+            index += blockSize;
+        }
+    }
+    largestFree = largestFreeBlock();
+}
+
+BuddyMemoryAllocator::~BuddyMemoryAllocator() {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    memory.clear();
+    freeLists.clear();
+}
+
+size_t BuddyMemoryAllocator::orderFor(size_t size) {
+    size_t order = 0;
+    while ((size_t(1) << order) < size) {
+        order++;
+    }
+    return order;
+}
+
+void* BuddyMemoryAllocator::allocate(std::shared_ptr<Process> process) {
+    size_t size = process->getMemoryRequired();
+    size_t order = orderFor(size);
+
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    if (order > maxOrder) {
+        return nullptr;
+    }
+
+    // Smallest free block that is large enough; lowest address within an order
+    size_t current = order;
+    while (current <= maxOrder && freeLists[current].empty()) {
+        current++;
+    }
+    if (current > maxOrder) {
+        return nullptr;
+    }
+
+    size_t index = *freeLists[current].begin();
+    freeLists[current].erase(freeLists[current].begin());
+    nFreeBlocks--;
+
+    // Split down to the requested order, keeping the lower half each time
+    while (current > order) {
+        current--;
+        freeLists[current].insert(index + (size_t(1) << current));
+        nFreeBlocks++;
+        nSplits++;
+    }
+    largestFree = largestFreeBlock();
+
+    size_t blockSize = size_t(1) << order;
+    blockOrder[index] = order;
+    freeSize -= blockSize;
+    internalFragmentation += blockSize - size;
+    processList[index] = process;
+    residentBlocks.load(index, *process, &memory[index], &memory[0]);
+    nProcess++;
+    reclaimer.noteFree(freeSize);
+    return reinterpret_cast<void*>(&memory[index]);
+}
+
+void BuddyMemoryAllocator::deallocate(std::shared_ptr<Process> process) {
+    {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+
+        // Never placed, or already swapped out
+        if (!process->getMemory()) {
+            return;
+        }
+        size_t index = static_cast<char*>(process->getMemory()) - &memory[0];
+        if (index >= maximumSize || !blockOrder.count(index) || !processList.count(index)) {
+            return;
+        }
+        releaseBlock(index, *process);
+    }
+    residentBlocks.notifyRelease();
+}
+
+void BuddyMemoryAllocator::releaseBlock(size_t index, Process& process) {
+    auto it = blockOrder.find(index);
+    size_t order = it->second;
+    blockOrder.erase(it);
+    freeSize += size_t(1) << order;
+    internalFragmentation -= (size_t(1) << order) - process.getMemoryRequired();
+    insertFreeBlock(index, order);
+    processList.erase(index);
+    residentBlocks.release(index, process);
+    nProcess--;
+}
+
+void BuddyMemoryAllocator::insertFreeBlock(size_t index, size_t order) {
+    while (order < maxOrder) {
+        size_t buddy = index ^ (size_t(1) << order);
+        auto it = freeLists[order].find(buddy);
+        if (it == freeLists[order].end()) {
+            break;
+        }
+        freeLists[order].erase(it);
+        nFreeBlocks--;
+        index = std::min(index, buddy);
+        order++;
+        nCoalesces++;
+    }
+    freeLists[order].insert(index);
+    nFreeBlocks++;
+    largestFree = largestFreeBlock();
+}
+
+size_t BuddyMemoryAllocator::largestFreeBlock() const {
+    for (size_t order = freeLists.size(); order-- > 0;) {
+        if (!freeLists[order].empty()) {
+            return size_t(1) << order;
+        }
+    }
+    return 0;
+}
+
+void BuddyMemoryAllocator::visualizeMemory() {
+
+}
+
+int BuddyMemoryAllocator::getNProcess() {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    return nProcess;
+}
+
+std::map<size_t, std::shared_ptr<Process>> BuddyMemoryAllocator::getProcessList() {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    return processList;
+}
+
+size_t BuddyMemoryAllocator::getMaxMemory() {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    return maximumSize;
+}
+
+size_t BuddyMemoryAllocator::getExternalFragmentation() {
+    return freeSize;
+}
+
+size_t BuddyMemoryAllocator::getLargestFreeBlock() {
+    return largestFree;
+}
+
+size_t BuddyMemoryAllocator::getFreeBlockCount() {
+    return nFreeBlocks;
+}
+
+size_t BuddyMemoryAllocator::getInternalFragmentation() {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    return internalFragmentation;
+}
+
+void BuddyMemoryAllocator::printStats(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    out << std::setw(12) << nSplits << " buddy splits" << std::endl;
+    out << std::setw(12) << nCoalesces << " buddy coalesces" << std::endl;
+    residentBlocks.printStats(out);
+    reclaimer.printStats(out);
+}
+
+// Any freed block may merge into one large enough, so the request size does not pick the victim
+bool BuddyMemoryAllocator::deallocateOldest(size_t /*memSize*/) {
+    if (evictVictim()) {
+        reclaimer.recordDirectReclaim();
+        return true;
+    }
+    if (getNProcess() == 0) {
+        std::cerr << "No process found to deallocate.\n";
+    }
+    return false;
+}
+
+bool BuddyMemoryAllocator::evictVictim() {
+    std::unique_lock<std::mutex> lock(memoryMutex);
+
+    size_t nSlots = 0;
+    size_t index = residentBlocks.swapOutVictim(processList, &memory[0], nSlots);
+    if (index == ReplacementPolicy::NONE) {
+        return false;
+    }
+
+    std::shared_ptr<Process> victimProcess = processList[index];
+    releaseBlock(index, *victimProcess);
+    lock.unlock();
+
+    backingStore.logSwapOut(*victimProcess, "Swap Slots: " + std::to_string(nSlots));
+    return true;
+}
+
+bool BuddyMemoryAllocator::pin(std::shared_ptr<Process> process) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    if (!process->getMemory()) {
+        return false;
+    }
+    residentBlocks.pin(static_cast<char*>(process->getMemory()) - &memory[0], *process);
+    return true;
+}
+
+void BuddyMemoryAllocator::unpin(std::shared_ptr<Process> process) {
+    {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        residentBlocks.unpin(*process);
+    }
+    residentBlocks.notifyRelease();
+}
+
+size_t BuddyMemoryAllocator::getReleaseCount() {
+    return residentBlocks.getReleaseCount();
+}
+
+void BuddyMemoryAllocator::setReleaseListener(std::function<void()> listener) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    residentBlocks.setReleaseListener(std::move(listener));
+}
+
+size_t BuddyMemoryAllocator::getPageIn(){
+    return 0;
+}
+size_t BuddyMemoryAllocator::getPageOut(){
+    return 0;
+}
+
+// A buddy block is never partly swapped out, so there is nothing to fault in
+int BuddyMemoryAllocator::accessPage(Process&, size_t){
+    return 0;
+}
+size_t BuddyMemoryAllocator::getResidentMemory(const Process& process){
+    return process.getMemoryRequired();
+}
+
+void BuddyMemoryAllocator::setReplacementPolicy(std::unique_ptr<ReplacementPolicy> policy){
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    residentBlocks.setPolicy(std::move(policy));
+}
+
+BackingStore& BuddyMemoryAllocator::getBackingStore(){
+    return backingStore;
+}
+
+void BuddyMemoryAllocator::setReclaimWatermarks(int lowPercent, int highPercent){
+    reclaimer.setWatermarks(maximumSize * lowPercent / 100, maximumSize * highPercent / 100);
+}
@@ -1,25 +1,62 @@
 #include "../include/CPUClock.h"
 
+#include <chrono>
+#include <ctime>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
 CPUClock::CPUClock() : cpuClock(0), activeNum(0){}
 
 int CPUClock::getCPUClock() {
     return cpuClock.load();
 }
 
+void CPUClock::setClockMode(const std::string& mode) {
+    virtualTime = (mode == "virtual");
+}
+
+bool CPUClock::isVirtual() const {
+    return virtualTime;
+}
+
+void CPUClock::reserveParticipants(int n) {
+    slots.reset(new TickSlot[n]);
+    slotCapacity = n;
+    nSlots = 0;
+}
+
+int CPUClock::registerParticipant() {
+    int slot = nSlots.fetch_add(1);
+    if (slot >= slotCapacity) {
+        std::cerr << "Error: Clock participant limit of " << slotCapacity << " reached!" << std::endl;
+        nSlots--;
+        return -1;
+    }
+    return slot;
+}
+
+int CPUClock::getParticipantCount() const {
+    return nSlots.load();
+}
+
 void CPUClock::startCPUClock() {
     if (!isRunning) {
         isRunning = true;
-        std::cout << "CPU Clock started\n";
+        hostCpuAtStart = hostCpuSeconds();
+        tickAtStart = cpuClock.load();
+        std::cout << "CPU Clock started" << (virtualTime ? " (virtual time)" : "") << "\n";
+
+        // Virtual time is advanced by the last participant to park, no clock thread needed
+        if (virtualTime) {
+            return;
+        }
         CPUClockThread = std::thread([this]() {
             while (isRunning) {
-                {
-                    std::lock_guard<std::mutex> lock(clockMutex);
-                    cpuClock++;
-                }
-                
-                cycleCondition.notify_all(); // Notify on each tick
+                wakeParked(++cpuClock);
                 std::this_thread::sleep_for(std::chrono::milliseconds(1));
-               
             }
         });
     }
@@ -33,12 +70,214 @@ void CPUClock::stopCPUClock() {
     }
 }
 
+void CPUClock::joinParticipant(int slot) {
+    if (!virtualTime || slot < 0) {
+        return;
+    }
+    holdTick();
+    joinHeldParticipant(slot);
+}
+
+void CPUClock::leaveParticipant(int slot) {
+    if (!virtualTime || slot < 0) {
+        return;
+    }
+    slots[slot].wake = TICK_IDLE;
+    arrivals++;
+    if (pendingParticipants.fetch_sub(1) == 1) {
+        tryAdvance();
+    }
+}
+
+void CPUClock::holdTick() {
+    if (virtualTime) {
+        pendingParticipants++;
+    }
+}
+
+void CPUClock::joinHeldParticipant(int slot) {
+    if (virtualTime && slot >= 0) {
+        slots[slot].wake = TICK_RUNNING;
+    }
+}
+
+int CPUClock::waitForTick(int slot, int tick) {
+    int spins = 0;
+    if (cpuClock.load() >= tick) {
+        return cpuClock.load();
+    }
+
+    if (slot < 0) {
+        return waitForTickObserved(tick, std::chrono::milliseconds::max());
+    }
+    if (!virtualTime) {
+        return waitForTickParked(slot, tick);
+    }
+
+    // Arrive at the barrier; the last one to arrive moves the clock for everybody
+    slots[slot].wake = tick;
+    arrivals++;
+    if (pendingParticipants.fetch_sub(1) == 1) {
+        tryAdvance();
+    }
+
+    // Only our own slot is watched, the advancing thread flips it back to running
+    while (slots[slot].wake.load() != TICK_RUNNING) {
+        backoff(spins);
+    }
+    return cpuClock.load();
+}
+
+int CPUClock::waitForAdvance(int lastTick) {
+    // Time out so observers can notice shutdown while the virtual clock is idle
+    return waitForTickObserved(lastTick + 1, std::chrono::milliseconds(10));
+}
+
+// Sleeps on the slot's own condition variable until the wall clock reaches tick
+int CPUClock::waitForTickParked(int slot, int tick) {
+    TickSlot& parked = slots[slot];
+    std::unique_lock<std::mutex> lock(parked.mutex);
+
+    // wake is published before the tick is read, and the ticker advances the tick before
+    // reading wake, so one of the two always sees the other
+    parked.wake = tick;
+    parked.parked.wait(lock, [this, tick] { return cpuClock.load() >= tick; });
+    parked.wake = TICK_IDLE;
+    return cpuClock.load();
+}
+
+// Sleeps until the clock reaches tick or the timeout passes
+int CPUClock::waitForTickObserved(int tick, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(observerMutex);
+    nParkedObservers++;
+
+    auto due = [this, tick] { return cpuClock.load() >= tick; };
+    if (timeout == std::chrono::milliseconds::max()) {
+        observerCondition.wait(lock, due);
+    } else {
+        observerCondition.wait_for(lock, timeout, due);
+    }
+
+    nParkedObservers--;
+    return cpuClock.load();
+}
+
+// Only slots whose tick has come are notified, each under its own mutex
+void CPUClock::wakeParked(int tick) {
+    if (!virtualTime) {
+        int n = nSlots.load();
+        for (int i = 0; i < n; ++i) {
+            int wake = slots[i].wake.load();
+            if (wake != TICK_IDLE && wake <= tick) {
+                std::lock_guard<std::mutex> lock(slots[i].mutex);
+                slots[i].parked.notify_one();
+            }
+        }
+    }
+    if (nParkedObservers.load() > 0) {
+        std::lock_guard<std::mutex> lock(observerMutex);
+        observerCondition.notify_all();
+    }
+}
+
+// Serializes advancers without a mutex; repeats if someone arrived meanwhile so no arrival is lost
+void CPUClock::tryAdvance() {
+    for (;;) {
+        if (pendingParticipants.load() != 0 || advancing.test_and_set()) {
+            return;
+        }
+
+        unsigned seen = arrivals.load();
+        if (pendingParticipants.load() == 0) {
+            advance();
+        }
+        advancing.clear();
+
+        if (arrivals.load() == seen) {
+            return;
+        }
+    }
+}
+
+// Every participant is parked: jump to the earliest requested tick and release whoever is due
+void CPUClock::advance() {
+    int n = nSlots.load();
+    int next = TICK_IDLE;
+
+    for (int i = 0; i < n; ++i) {
+        int wake = slots[i].wake.load();
+        if (wake != TICK_RUNNING && wake < next) {
+            next = wake;
+        }
+    }
+
+    if (next == TICK_IDLE) {
+        return;  // Nobody is waiting on the clock
+    }
+    if (next > cpuClock.load()) {
+        cpuClock = next;
+    }
+
+    int tick = cpuClock.load();
+    wakeParked(tick);
+    for (int i = 0; i < n; ++i) {
+        int wake = slots[i].wake.load();
+        if (wake != TICK_RUNNING && wake != TICK_IDLE && wake <= tick) {
+            // Count the participant busy before it can run and arrive again
+            pendingParticipants++;
+            if (!slots[i].wake.compare_exchange_strong(wake, TICK_RUNNING)) {
+                pendingParticipants--;
+            }
+        }
+    }
+}
+
+void CPUClock::backoff(int& spins) {
+    if (spins < 64) {
+        spins++;
+    } else if (spins < 128) {
+        spins++;
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+double CPUClock::hostCpuSeconds() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (k.QuadPart + u.QuadPart) / 1e7;  // 100 ns units
+#else
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+double CPUClock::getHostMicrosPerTick() {
+    int ticks = cpuClock.load() - tickAtStart;
+    if (ticks <= 0) {
+        return 0;
+    }
+    return (hostCpuSeconds() - hostCpuAtStart) * 1e6 / ticks;
+}
+
+double CPUClock::getHostCpuSeconds() {
+    return hostCpuSeconds() - hostCpuAtStart;
+}
+
 
 std::atomic<int> CPUClock::getActiveCPUNum(){
     return activeNum.load();
 }
 
 
-void CPUClock::incrementActiveCPUNum(){
-    activeNum++;
-}
\ No newline at end of file
+void CPUClock::incrementActiveCPUNum(int ticks){
+    activeNum += ticks;
+}
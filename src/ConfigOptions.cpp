@@ -0,0 +1,78 @@
+#include "../include/ConfigOptions.h"
+
+#include <iomanip>
+
+bool ConfigOptions::parse(const std::string& key, std::istream& in)
+{
+    if (key == "clock-mode") {
+        in >> std::quoted(clock_mode);
+    } else if (key == "exec-mode") {
+        in >> std::quoted(exec_mode);
+    } else if (key == "host-threads") {
+        in >> host_threads;
+    } else if (key == "context-switch-cycles") {
+        in >> context_switch_cycles;
+    } else if (key == "mem-allocator") {
+        in >> std::quoted(mem_allocator);
+    } else if (key == "page-access") {
+        in >> std::quoted(page_access);
+    } else if (key == "minor-fault-cycles") {
+        in >> minor_fault_cycles;
+    } else if (key == "major-fault-cycles") {
+        in >> major_fault_cycles;
+    } else if (key == "replacement-policy") {
+        in >> std::quoted(replacement_policy);
+    } else if (key == "working-set-window") {
+        in >> working_set_window;
+    } else if (key == "swap-debug-log") {
+        in >> swap_debug_log;
+    } else if (key == "swap-queue-depth") {
+        in >> swap_queue_depth;
+    } else if (key == "reclaim-low-watermark") {
+        in >> reclaim_low_watermark;
+    } else if (key == "reclaim-high-watermark") {
+        in >> reclaim_high_watermark;
+    } else if (key == "flat-placement") {
+        in >> std::quoted(flat_placement);
+    } else if (key == "compaction-threshold") {
+        in >> compaction_threshold;
+    } else if (key == "compaction-budget") {
+        in >> compaction_budget;
+    } else if (key == "frame-placement") {
+        in >> std::quoted(frame_placement);
+    } else if (key == "huge-frame-multiple") {
+        in >> huge_frame_multiple;
+    } else if (key == "process-output") {
+        in >> std::quoted(process_output);
+    } else if (key == "blocking-percent") {
+        in >> blocking_percent;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void ConfigOptions::print(std::ostream& out) const
+{
+    out << "clock-mode: " << clock_mode << std::endl;
+    out << "exec-mode: " << exec_mode << std::endl;
+    out << "host-threads: " << host_threads << std::endl;
+    out << "context-switch-cycles: " << context_switch_cycles << std::endl;
+    out << "mem-allocator: " << mem_allocator << std::endl;
+    out << "page-access: " << page_access << std::endl;
+    out << "minor-fault-cycles: " << minor_fault_cycles << std::endl;
+    out << "major-fault-cycles: " << major_fault_cycles << std::endl;
+    out << "replacement-policy: " << replacement_policy << std::endl;
+    out << "working-set-window: " << working_set_window << std::endl;
+    out << "swap-debug-log: " << swap_debug_log << std::endl;
+    out << "swap-queue-depth: " << swap_queue_depth << std::endl;
+    out << "reclaim-low-watermark: " << reclaim_low_watermark << std::endl;
+    out << "reclaim-high-watermark: " << reclaim_high_watermark << std::endl;
+    out << "flat-placement: " << flat_placement << std::endl;
+    out << "compaction-threshold: " << compaction_threshold << std::endl;
+    out << "compaction-budget: " << compaction_budget << std::endl;
+    out << "frame-placement: " << frame_placement << std::endl;
+    out << "huge-frame-multiple: " << huge_frame_multiple << std::endl;
+    out << "process-output: " << process_output << std::endl;
+    out << "blocking-percent: " << blocking_percent << std::endl;
+}
@@ -104,6 +104,12 @@ void ConsoleManager::handleCommand(const std::string &command)
             config_file >> temp >> min_mem_per_proc;
             config_file >> temp >> max_mem_per_proc;
 
+            // Optional settings follow as "key value" pairs in any order
+            while (config_file >> temp) {
+                if (!options.parse(temp, config_file)) {
+                    std::getline(config_file, temp);  // Skip unknown settings
+                }
+            }
 
             config_file.close();  // Close the file after reading
 
@@ -119,13 +125,16 @@ void ConsoleManager::handleCommand(const std::string &command)
             std::cout << "mem-per-frame: " << mem_per_frame << std::endl;
             std::cout << "min-mem-per-proc: " << min_mem_per_proc << std::endl;
             std::cout << "max-mem-per-proc: " << max_mem_per_proc << std::endl;
+            options.print(std::cout);
 
             cpuClock = new CPUClock();
+            cpuClock->setClockMode(options.clock_mode);
+            cpuClock->reserveParticipants(nCPU + 8);  // Cores plus service threads
             cpuClock->startCPUClock();
 
 
             processManager = new ProcessManager(min_ins, max_ins, nCPU, scheduler, delays_per_exec, quantum_cycles, cpuClock, max_mem
-                                                , mem_per_frame, min_mem_per_proc, max_mem_per_proc);
+                                                , mem_per_frame, min_mem_per_proc, max_mem_per_proc, options);
 
             initialized = true;
 
@@ -174,29 +183,31 @@ void ConsoleManager::handleCommand(const std::string &command)
             std::cout << "Scheduler-test started\n";
 
             schedulerThread = std::thread([this]() {
-                int tickCounter = 0;
-                std::unique_lock<std::mutex> lock(cpuClock->getMutex(), std::defer_lock);
+                if (generatorSlot < 0) {
+                    generatorSlot = cpuClock->registerParticipant();
+                }
+                int lastTick = cpuClock->getCPUClock();
+                cpuClock->joinParticipant(generatorSlot);
 
                 while (schedulerRunning) {
-                    // Wait for each CPU tick
-                    lock.lock();
-                    cpuClock->getCondition().wait(lock);
-                    lock.unlock();
-
-                    // Increment tick counter on each tick
-                    tickCounter++;
                     // Generate session after every batch_process_freq ticks
-                    if (tickCounter >= batch_process_freq) {
-                        tickCounter = 0; // Reset counter
-                        std::string name = "Process_" + std::to_string(screens.size());
-                        generateSession(name);
-                    }
+                    lastTick = cpuClock->waitForTick(generatorSlot, lastTick + batch_process_freq);
+                    std::string name = "Process_" + std::to_string(screens.size());
+                    generateSession(name);
                     
                     if(screens.size() > 4){
-                        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                        if (cpuClock->isVirtual()) {
+                            // The 50 ticks the wall clock would pass during the sleep below
+                            lastTick = cpuClock->waitForTick(generatorSlot, lastTick + 50);
+                        } else {
+                            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                            lastTick = cpuClock->getCPUClock();
+                        }
                     }
                     
                 }
+
+                cpuClock->leaveParticipant(generatorSlot);
             });
         } else {
             std::cout << "[ERROR] \"scheduler-test\" command is already running\n";
@@ -227,6 +238,9 @@ void ConsoleManager::handleCommand(const std::string &command)
     else if (command == "exit")
     {
         std::cout << "Exiting..." << std::endl;
+        if (initialized) {
+            processManager->flushOutput();
+        }
         exit(0);
     }
     else
@@ -98,6 +98,13 @@ void ConsoleScreen::displayAllProcessToStream(std::map<std::string, std::shared_
             << process->getLinesOfCode() << std::endl;
             running << temp.str() << std::endl;
         }
+        if (process->getState() == Process::WAITING)
+        {
+            temp << "  WAITING   "
+            << process->getCommandCounter() << " / " 
+            << process->getLinesOfCode() << std::endl;
+            running << temp.str() << std::endl;
+        }
         if (process->getState() == Process::FINISHED)
         {
             temp << "  FINISHED " << "   "
@@ -123,7 +130,7 @@ void ConsoleScreen::displayAllProcessToStream(std::map<std::string, std::shared_
 
 void ConsoleScreen::displayUpdatedProcess(std::shared_ptr<Process> process)
 {
-    if (process->getState() == Process::RUNNING || process->getState() == Process::READY)
+    if (process->getState() != Process::FINISHED)
     {
         std::cout << CYAN << "Screen: " << process->getName() << RESET << std::endl;
         std::cout << "Current instruction line: " << process->getCommandCounter() << std::endl;
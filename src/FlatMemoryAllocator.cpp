@@ -8,47 +8,274 @@
 #include <chrono>
 #include <iomanip>  // For std::put_time
 #include <memory>
+#include <algorithm>
+#include <sstream>
+#include <cstdint>
 
 FlatMemoryAllocator::FlatMemoryAllocator(size_t maximumSize, size_t mem_per_frame) 
-    : maximumSize(maximumSize), allocatedSize(0), memory(maximumSize, '.'), allocationMap(maximumSize, false), mem_per_frame(mem_per_frame), nProcess(0) {
+    : maximumSize(maximumSize), mem_per_frame(mem_per_frame), allocatedSize(0), nProcess(0),
+      backingStore("backingstore.bin", SWAP_SLOT_BYTES, INITIAL_SWAP_SLOTS), residentBlocks(backingStore),
+      placement(Placement::FIRST_FIT), nextFitCursor(0), nPlacements(0), nFailedPlacements(0), placementNanos(0),
+      fragmentationSum(0), peakFragmentation(0), compactionThreshold(0), compactionBudget(0), nCompactions(0),
+      compactedSize(0), nEvictionsAvoided(0),
+      reclaimer([this] { return freeBytes.load(); },
+                [this] { return evictVictim(); }) {
+    sizeClasses.resize(sizeClass(std::max<size_t>(maximumSize, 1)) + 1);
     initializeMemory();
 }
 
 FlatMemoryAllocator::~FlatMemoryAllocator() {
-    std::lock_guard<std::mutex> lock(memoryMutex);  // Ensure memory is safely cleared
-    memory.clear();
-    allocationMap.clear();
+}
+
+// Handles are offsets in disguise; nothing ever dereferences them, so the pool needs no host memory
+void* FlatMemoryAllocator::toHandle(size_t index) {
+    return reinterpret_cast<void*>(static_cast<uintptr_t>(index) + 1);
+}
+
+size_t FlatMemoryAllocator::toIndex(const void* handle) {
+    return handle ? static_cast<size_t>(reinterpret_cast<uintptr_t>(handle)) - 1 : NO_BLOCK;
 }
 
 void* FlatMemoryAllocator::allocate(std::shared_ptr<Process> process) {
     size_t size = process->getMemoryRequired();
 
     std::lock_guard<std::mutex> lock(memoryMutex);  // Lock mutex to prevent concurrent access
-    for (auto it = freeBlocks.begin(); it != freeBlocks.end(); ++it) {
-        size_t blockStart = it->first;
-        size_t blockSize = it->second;
+    // Past the threshold, pay for a compaction pass now rather than for evictions later
+    if (compactionThreshold > 0 && freeBytes > 0 &&
+        100 * (freeBytes - largestFree) >= static_cast<size_t>(compactionThreshold) * freeBytes) {
+        compact(largestFree + 1);  // Any region that can grow the largest free block
+    }
 
-        if (blockSize >= size) {
-            allocateAt(blockStart, size);
-            nProcess++;
-            processList[blockStart] = process;
-            return reinterpret_cast<void*>(&memory[blockStart]);  // Return pointer to start of allocated block
+    auto searchStart = std::chrono::steady_clock::now();
+    size_t blockStart = findFreeBlock(size);
+    placementNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - searchStart).count();
+    nPlacements++;
+    if (blockStart == NO_BLOCK && freeBytes >= size && compact(size)) {
+        blockStart = findFreeBlock(size);
+        if (blockStart != NO_BLOCK) {
+            nEvictionsAvoided++;
         }
     }
-    return nullptr;  // No sufficient contiguous block found
+    if (blockStart == NO_BLOCK) {
+        nFailedPlacements++;
+        return nullptr;  // No sufficient contiguous block found
+    }
+
+    allocateAt(blockStart, size);
+    nextFitCursor = blockStart + size;
+    nProcess++;
+    processList[blockStart] = process;
+    residentBlocks.load(blockStart, *process, toHandle(blockStart), nullptr);
+
+    // Share of free memory outside the largest free block, i.e. unusable for a request that size
+    size_t freeSize = freeBytes;
+    double fragmentation = freeSize ? 1.0 - static_cast<double>(largestFree) / freeSize : 0.0;
+    fragmentationSum += fragmentation;
+    peakFragmentation = std::max(peakFragmentation, fragmentation);
+
+    reclaimer.noteFree(freeSize);
+    return toHandle(blockStart);
+}
+
+size_t FlatMemoryAllocator::findFreeBlock(size_t size) {
+    switch (placement) {
+    case Placement::BEST_FIT: {
+        // Ties go to the lowest address
+        auto it = freeBySize.lower_bound({size, 0});
+        return it == freeBySize.end() ? NO_BLOCK : it->second;
+    }
+    case Placement::WORST_FIT: {
+        if (freeBySize.empty() || freeBySize.rbegin()->first < size) {
+            return NO_BLOCK;
+        }
+        return freeBySize.lower_bound({freeBySize.rbegin()->first, 0})->second;
+    }
+    case Placement::NEXT_FIT: {
+        // Search up from the cursor, then wrap around to the blocks below it
+        auto start = freeBlocks.lower_bound(nextFitCursor);
+        for (auto it = start; it != freeBlocks.end(); ++it) {
+            if (it->second >= size) {
+                return it->first;
+            }
+        }
+        for (auto it = freeBlocks.begin(); it != start; ++it) {
+            if (it->second >= size) {
+                return it->first;
+            }
+        }
+        return NO_BLOCK;
+    }
+    case Placement::SEGREGATED: {
+        // Blocks in the request's own class may still be too small; any block in a higher class fits
+        size_t first = sizeClass(size);
+        if (first >= sizeClasses.size()) {
+            return NO_BLOCK;
+        }
+        for (size_t start : sizeClasses[first]) {
+            if (freeBlocks.find(start)->second >= size) {
+                return start;
+            }
+        }
+        for (size_t sc = first + 1; sc < sizeClasses.size(); ++sc) {
+            if (!sizeClasses[sc].empty()) {
+                return *sizeClasses[sc].begin();
+            }
+        }
+        return NO_BLOCK;
+    }
+    case Placement::FIRST_FIT:
+    default:
+        for (auto it = freeBlocks.begin(); it != freeBlocks.end(); ++it) {
+            if (it->second >= size) {
+                return it->first;
+            }
+        }
+        return NO_BLOCK;
+    }
+}
+
+void FlatMemoryAllocator::setCompaction(int thresholdPercent, size_t budget) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    compactionThreshold = thresholdPercent;
+    compactionBudget = budget;
+}
+
+// Running processes are pinned and cannot move, so they split memory into regions that are
+// compacted independently. The first region holding enough free memory for size is chosen;
+// when there is none, moving blocks would not help and compaction leaves it to eviction.
+bool FlatMemoryAllocator::findCompactionRegion(size_t size, size_t& regionStart, size_t& regionEnd) const {
+    size_t start = 0;
+    size_t movable = 0;  // KB of unpinned blocks since start
+    for (const auto& block : processList) {
+        size_t blockSize = block.second->getMemoryRequired();
+        if (!residentBlocks.isPinned(*block.second)) {
+            movable += blockSize;
+            continue;
+        }
+        if (block.first - start - movable >= size) {
+            regionStart = start;
+            regionEnd = block.first;
+            return true;
+        }
+        start = block.first + blockSize;
+        movable = 0;
+    }
+    regionStart = start;
+    regionEnd = maximumSize;
+    return maximumSize - start - movable >= size;
+}
+
+// Each step slides the block just above the lowest free gap of the region down into it, so
+// the gap moves up and merges with the next one. The budget bounds how long memoryMutex is
+// held per pass; a later pass carries on from wherever this one stopped. Moving a block only
+// renames its offset, but the KB a real move would copy still count against the budget.
+bool FlatMemoryAllocator::compact(size_t size) {
+    size_t regionStart, regionEnd;
+    if (largestFree >= size || !findCompactionRegion(size, regionStart, regionEnd)) {
+        return false;
+    }
+
+    size_t moved = 0;
+    while (largestFree < size && moved < compactionBudget) {
+        auto gap = freeBlocks.lower_bound(regionStart);
+        if (gap == freeBlocks.end() || gap->first >= regionEnd) {
+            break;
+        }
+        size_t gapStart = gap->first;
+        size_t gapSize = gap->second;
+        auto owner = processList.find(gapStart + gapSize);
+        if (owner == processList.end() || gapStart + gapSize >= regionEnd) {
+            break;  // The gap already reaches the top of the region
+        }
+        std::shared_ptr<Process> process = owner->second;
+        size_t blockSize = process->getMemoryRequired();
+
+        processList.erase(owner);
+        processList[gapStart] = process;
+        residentBlocks.relocate(gapStart + gapSize, gapStart);
+        process->setMemory(toHandle(gapStart));
+
+        // The gap now sits above the moved block, next to whatever followed it
+        removeFreeBlock(gap);
+        size_t freeStart = gapStart + blockSize;
+        size_t freeSize = gapSize;
+        auto next = freeBlocks.find(freeStart + freeSize);
+        if (next != freeBlocks.end()) {
+            freeSize += next->second;
+            removeFreeBlock(next);
+        }
+        addFreeBlock(freeStart, freeSize);
+        moved += blockSize;
+        regionStart = freeStart;
+    }
+
+    if (moved > 0) {
+        nCompactions++;
+        compactedSize += moved;
+    }
+    return moved > 0;
+}
+
+void FlatMemoryAllocator::setPlacement(const std::string& name) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    if (name == "best-fit") {
+        placement = Placement::BEST_FIT;
+    } else if (name == "worst-fit") {
+        placement = Placement::WORST_FIT;
+    } else if (name == "next-fit") {
+        placement = Placement::NEXT_FIT;
+    } else if (name == "segregated") {
+        placement = Placement::SEGREGATED;
+    } else {
+        placement = Placement::FIRST_FIT;
+    }
+}
+
+size_t FlatMemoryAllocator::sizeClass(size_t size) const {
+    size_t sc = 0;
+    while ((size_t(2) << sc) <= size) {
+        sc++;
+    }
+    return sc;
+}
+
+void FlatMemoryAllocator::addFreeBlock(size_t index, size_t size) {
+    freeBlocks[index] = size;
+    freeBySize.insert({size, index});
+    sizeClasses[sizeClass(size)].insert(index);
+    freeBytes += size;
+    nFreeBlocks++;
+    largestFree = freeBySize.rbegin()->first;
+}
+
+void FlatMemoryAllocator::removeFreeBlock(std::map<size_t, size_t>::iterator it) {
+    freeBySize.erase({it->second, it->first});
+    sizeClasses[sizeClass(it->second)].erase(it->first);
+    freeBytes -= it->second;
+    nFreeBlocks--;
+    freeBlocks.erase(it);
+    largestFree = freeBySize.empty() ? 0 : freeBySize.rbegin()->first;
 }
 
 
 void FlatMemoryAllocator::deallocate(std::shared_ptr<Process> process) {
-    std::lock_guard<std::mutex> lock(memoryMutex);  // Lock mutex for thread-safe deallocation
+    {
+        std::lock_guard<std::mutex> lock(memoryMutex);  // Lock mutex for thread-safe deallocation
 
-    size_t index = static_cast<char*>(process->getMemory()) - &memory[0];
-    if (index < maximumSize && processList.count(index)) {
-        size_t size = process->getMemoryRequired();
-        deallocateAt(index, size);
-        processList.erase(index);
-        nProcess--;
+        size_t index = toIndex(process->getMemory());
+        if (index >= maximumSize || !processList.count(index)) {
+            return;
+        }
+        releaseBlock(index, *process);
     }
+    residentBlocks.notifyRelease();
+}
+
+void FlatMemoryAllocator::releaseBlock(size_t index, Process& process) {
+    deallocateAt(index, process.getMemoryRequired());
+    processList.erase(index);
+    residentBlocks.release(index, process);
+    nProcess--;
 }
 
 
@@ -58,10 +285,17 @@ void FlatMemoryAllocator::visualizeMemory() {
 
 void FlatMemoryAllocator::initializeMemory() {
     std::lock_guard<std::mutex> lock(memoryMutex);
-    std::fill(memory.begin(), memory.end(), '.');
-    std::fill(allocationMap.begin(), allocationMap.end(), false);
     freeBlocks.clear();
-    freeBlocks[0] = maximumSize;  // Entire memory is initially free
+    freeBySize.clear();
+    freeBytes = 0;
+    largestFree = 0;
+    nFreeBlocks = 0;
+    for (std::set<size_t>& sizeClassList : sizeClasses) {
+        sizeClassList.clear();
+    }
+    if (maximumSize > 0) {
+        addFreeBlock(0, maximumSize);  // Entire memory is initially free
+    }
 }
 
 
@@ -78,14 +312,14 @@ void FlatMemoryAllocator::allocateAt(size_t index, size_t size) {
     if (it != freeBlocks.end() && it->first <= index && it->first + it->second >= index + size) {
         size_t blockStart = it->first;
         size_t blockSize = it->second;
-        freeBlocks.erase(it);
+        removeFreeBlock(it);
 
         // Adjust the free block before and/or after the allocation
         if (blockStart < index) {
-            freeBlocks[blockStart] = index - blockStart; // Remaining free space before allocation
+            addFreeBlock(blockStart, index - blockStart); // Remaining free space before allocation
         }
         if (index + size < blockStart + blockSize) {
-            freeBlocks[index + size] = (blockStart + blockSize) - (index + size); // Remaining free space after allocation
+            addFreeBlock(index + size, (blockStart + blockSize) - (index + size)); // Remaining free space after allocation
         }
 
         allocatedSize += size;
@@ -105,17 +339,17 @@ void FlatMemoryAllocator::deallocateAt(size_t index, size_t size) {
     if (prev != freeBlocks.end() && prev->first + prev->second == index) {
         newStart = prev->first;
         newSize += prev->second;
-        freeBlocks.erase(prev);
+        removeFreeBlock(prev);
     }
 
     // Check if the next free block can be merged
     if (next != freeBlocks.end() && index + size == next->first) {
         newSize += next->second;
-        freeBlocks.erase(next);
+        removeFreeBlock(next);
     }
 
     // Insert the merged free block into the map
-    freeBlocks[newStart] = newSize;
+    addFreeBlock(newStart, newSize);
 
     allocatedSize -= size;
 }
@@ -137,98 +371,81 @@ size_t FlatMemoryAllocator::getMaxMemory() {
 }
 
 size_t FlatMemoryAllocator::getExternalFragmentation() {
-    std::lock_guard<std::mutex> lock(memoryMutex);  // Lock mutex for thread-safe operation
-    size_t totalFreeSpace = 0;
-    size_t currentFreeBlockSize = 0;
-
-    for (size_t i = 0; i < maximumSize; ++i) {
-        if (!allocationMap[i]) {
-            // Current memory cell is free, so we're in a free block
-            currentFreeBlockSize++;
-        } else {
-            // When we encounter an allocated memory block, check if there was a free block before
-            if (currentFreeBlockSize > 0) {
-                totalFreeSpace += currentFreeBlockSize;  // Add the free block size to the total
-                currentFreeBlockSize = 0;  // Reset the free block size counter
-            }
-        }
-    }
-
-    // If there is a free block at the end of the memory
-    if (currentFreeBlockSize > 0) {
-        totalFreeSpace += currentFreeBlockSize;
-    }
-
-    return totalFreeSpace;
+    return freeBytes;
 }
 
+size_t FlatMemoryAllocator::getLargestFreeBlock() {
+    return largestFree;
+}
 
+size_t FlatMemoryAllocator::getFreeBlockCount() {
+    return nFreeBlocks;
+}
 
-void FlatMemoryAllocator::deallocateOldest(size_t memSize) {
-    // Set the initial oldest time to the maximum possible time_point value
-    std::chrono::time_point<std::chrono::system_clock> oldestTime = std::chrono::time_point<std::chrono::system_clock>::max();
-    size_t oldestIndex = 0;  // To track the index of the oldest process
-    std::shared_ptr<Process> oldestProcess = nullptr;  // To store the oldest process
-
-    // Iterate through the process list to find the oldest process
-    for (const auto &pair : processList) {
-        size_t index = pair.first;
-        std::shared_ptr<Process> process = pair.second;
 
-        // Get the allocation time of the process
-        std::chrono::time_point<std::chrono::system_clock> allocTime = process->getAllocTime();
 
-        // Check if this process has the oldest allocation time and meets the memory requirements
-        if (allocTime < oldestTime) {
-            oldestTime = allocTime;
-            oldestIndex = index;
-            oldestProcess = process;
+bool FlatMemoryAllocator::deallocateOldest(size_t memSize) {
+    {
+        // Enough memory is free, just not in one piece: moving blocks is cheaper than a swap-out
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        if (freeBytes >= memSize && compact(memSize)) {
+            if (largestFree >= memSize) {
+                nEvictionsAvoided++;
+            }
+            return true;
         }
     }
+    if (evictVictim()) {
+        reclaimer.recordDirectReclaim();
+        return true;
+    }
+    if (getNProcess() == 0) {
+        std::cerr << "No process found to deallocate.\n";
+    }
+    return false;
+}
 
-    // Now, oldestProcess holds the process with the oldest allocation time
-    if (oldestProcess) {
-
-        while(oldestProcess->getState() == Process::ProcessState::RUNNING){
-            //wait until its not running
-        }
-        // Log the deallocation info to a backing store file
-        std::ofstream backingStore("backingstore.txt", std::ios::app);  // Open file in append mode
+bool FlatMemoryAllocator::evictVictim() {
+    std::unique_lock<std::mutex> lock(memoryMutex);
 
-        if (backingStore.is_open()) {
-            // Convert the allocation time to a human-readable format
-            std::time_t allocTime_t = std::chrono::system_clock::to_time_t(oldestProcess->getAllocTime());
-            std::tm allocTime_tm;
+    size_t nSlots = 0;
+    size_t index = residentBlocks.swapOutVictim(processList, nullptr, nSlots);
+    if (index == ReplacementPolicy::NONE) {
+        return false;
+    }
 
-            // Use localtime_s for thread safety
-            if (localtime_s(&allocTime_tm, &allocTime_t) == 0) { // Check for success
-                // Write the deallocation log
-                backingStore << "Process ID: " << oldestProcess->getPID();
-                backingStore << "  Name: " << oldestProcess->getName();
-                backingStore << "  Command Counter: " << oldestProcess->getCommandCounter()
-                    << "/" << oldestProcess->getLinesOfCode() << "\n";
-                backingStore << "Memory Size: " << oldestProcess->getMemoryRequired() << " KB\n";
-                backingStore << "Num Pages: " << oldestProcess->getNumPages() << "\n";
-                backingStore << "============================================================================\n";
+    std::shared_ptr<Process> victimProcess = processList[index];
+    releaseBlock(index, *victimProcess);
+    lock.unlock();
 
-                backingStore.close();
-            }
-            else {
-                // Handle the error if localtime_s fails
-                std::cerr << "Failed to convert time to local time format." << std::endl;
-            }
-        }
+    backingStore.logSwapOut(*victimProcess, "Swap Slots: " + std::to_string(nSlots));
+    return true;
+}
 
-        
-        if(oldestProcess->getState() != Process::ProcessState::FINISHED){
-            // Perform the deallocation
-            deallocate(oldestProcess);
-            oldestProcess->setMemory(nullptr);
-        }
+bool FlatMemoryAllocator::pin(std::shared_ptr<Process> process) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    if (!process->getMemory()) {
+        return false;
+    }
+    residentBlocks.pin(toIndex(process->getMemory()), *process);
+    return true;
+}
 
-    } else {
-        std::cerr << "No process found to deallocate.\n";
+void FlatMemoryAllocator::unpin(std::shared_ptr<Process> process) {
+    {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        residentBlocks.unpin(*process);
     }
+    residentBlocks.notifyRelease();
+}
+
+size_t FlatMemoryAllocator::getReleaseCount() {
+    return residentBlocks.getReleaseCount();
+}
+
+void FlatMemoryAllocator::setReleaseListener(std::function<void()> listener) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    residentBlocks.setReleaseListener(std::move(listener));
 }
 
 
@@ -238,3 +455,47 @@ size_t FlatMemoryAllocator::getPageIn(){
 size_t FlatMemoryAllocator::getPageOut(){
     return 0;
 }
+size_t FlatMemoryAllocator::getInternalFragmentation(){
+    return 0;
+}
+void FlatMemoryAllocator::printStats(std::ostream& out){
+    static const char* placementNames[] = { "first-fit", "best-fit", "worst-fit", "next-fit", "segregated" };
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    size_t nPlaced = nPlacements - nFailedPlacements;
+    std::ostringstream latency, avgFragmentation, peak;
+    latency << std::fixed << std::setprecision(2) << (nPlacements ? static_cast<double>(placementNanos) / nPlacements : 0.0);
+    avgFragmentation << std::fixed << std::setprecision(2) << (nPlaced ? 100.0 * fragmentationSum / nPlaced : 0.0);
+    peak << std::fixed << std::setprecision(2) << 100.0 * peakFragmentation;
+    out << std::setw(12) << placementNames[static_cast<int>(placement)] << " placement" << std::endl;
+    out << std::setw(12) << nPlacements << " placement searches" << std::endl;
+    out << std::setw(12) << nFailedPlacements << " failed placements" << std::endl;
+    out << std::setw(12) << latency.str() << " ns avg placement latency" << std::endl;
+    out << std::setw(12) << avgFragmentation.str() << " % avg external fragmentation" << std::endl;
+    out << std::setw(12) << peak.str() << " % peak external fragmentation" << std::endl;
+    out << std::setw(12) << nCompactions << " compaction passes" << std::endl;
+    out << std::setw(12) << compactedSize << " KB moved by compaction" << std::endl;
+    out << std::setw(12) << nEvictionsAvoided << " evictions avoided" << std::endl;
+    residentBlocks.printStats(out);
+    reclaimer.printStats(out);
+}
+
+// Blocks are resident as a whole, so a touch never faults; pin counts the references
+int FlatMemoryAllocator::accessPage(Process&, size_t){
+    return 0;
+}
+size_t FlatMemoryAllocator::getResidentMemory(const Process& process){
+    return process.getMemoryRequired();
+}
+
+void FlatMemoryAllocator::setReplacementPolicy(std::unique_ptr<ReplacementPolicy> policy){
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    residentBlocks.setPolicy(std::move(policy));
+}
+
+BackingStore& FlatMemoryAllocator::getBackingStore(){
+    return backingStore;
+}
+
+void FlatMemoryAllocator::setReclaimWatermarks(int lowPercent, int highPercent){
+    reclaimer.setWatermarks(maximumSize * lowPercent / 100, maximumSize * highPercent / 100);
+}
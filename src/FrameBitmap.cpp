@@ -0,0 +1,170 @@
+#include "../include/FrameBitmap.h"
+
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+constexpr size_t WORD_BITS = 64;
+
+// Bits [from, to) of a word, both relative to the word
+uint64_t bitRange(size_t from, size_t to)
+{
+    uint64_t high = to >= WORD_BITS ? ~uint64_t(0) : (uint64_t(1) << to) - 1;
+    return high & ~((uint64_t(1) << from) - 1);
+}
+}
+
+FrameBitmap::FrameBitmap(size_t nFrames)
+    : words((nFrames + WORD_BITS - 1) / WORD_BITS, ~uint64_t(0)), nFrames(nFrames), nFree(nFrames), searchHint(0)
+{
+    // Bits past the last frame stay clear so they never look free
+    if (nFrames % WORD_BITS) {
+        words.back() = bitRange(0, nFrames % WORD_BITS);
+    }
+}
+
+size_t FrameBitmap::size() const
+{
+    return nFrames;
+}
+
+size_t FrameBitmap::count() const
+{
+    return nFree;
+}
+
+bool FrameBitmap::isFree(size_t frame) const
+{
+    return frame < nFrames && (words[frame / WORD_BITS] >> (frame % WORD_BITS)) & 1;
+}
+
+size_t FrameBitmap::takeAny()
+{
+    for (size_t w = searchHint; w < words.size(); ++w) {
+        if (words[w]) {
+            searchHint = w;
+            size_t frame = w * WORD_BITS + countTrailingZeros(words[w]);
+            words[w] &= words[w] - 1;  // Clears the lowest set bit
+            nFree--;
+            return frame;
+        }
+    }
+    searchHint = words.size();
+    return NONE;
+}
+
+size_t FrameBitmap::takeRun(size_t length, size_t alignment)
+{
+    if (length == 0 || length > nFree) {
+        return NONE;
+    }
+    alignment = std::max<size_t>(alignment, 1);
+
+    size_t start = nextFree(searchHint * WORD_BITS);
+    while (start != NONE) {
+        start = (start + alignment - 1) / alignment * alignment;
+        if (start + length > nFrames) {
+            return NONE;
+        }
+        size_t blocked = firstTaken(start, start + length);
+        if (blocked == NONE) {
+            clearRun(start, length);
+            return start;
+        }
+        // No run can contain the allocated frame, so resume after it
+        start = nextFree(blocked + 1);
+    }
+    return NONE;
+}
+
+bool FrameBitmap::release(size_t frame)
+{
+    if (frame >= nFrames || isFree(frame)) {
+        return false;
+    }
+    words[frame / WORD_BITS] |= uint64_t(1) << (frame % WORD_BITS);
+    nFree++;
+    searchHint = std::min(searchHint, frame / WORD_BITS);
+    return true;
+}
+
+void FrameBitmap::releaseRun(size_t first, size_t length)
+{
+    for (size_t frame = first; frame < first + length; ++frame) {
+        release(frame);
+    }
+}
+
+size_t FrameBitmap::countSlow() const
+{
+    size_t total = 0;
+    for (uint64_t word : words) {
+        total += popCount(word);
+    }
+    return total;
+}
+
+size_t FrameBitmap::nextFree(size_t from) const
+{
+    if (from >= nFrames) {
+        return NONE;
+    }
+    size_t w = from / WORD_BITS;
+    uint64_t word = words[w] & bitRange(from % WORD_BITS, WORD_BITS);
+    while (!word) {
+        if (++w == words.size()) {
+            return NONE;
+        }
+        word = words[w];
+    }
+    return w * WORD_BITS + countTrailingZeros(word);
+}
+
+size_t FrameBitmap::firstTaken(size_t from, size_t to) const
+{
+    while (from < to) {
+        size_t w = from / WORD_BITS;
+        size_t wordEnd = std::min(to - w * WORD_BITS, WORD_BITS);
+        uint64_t taken = ~words[w] & bitRange(from % WORD_BITS, wordEnd);
+        if (taken) {
+            return w * WORD_BITS + countTrailingZeros(taken);
+        }
+        from = (w + 1) * WORD_BITS;
+    }
+    return NONE;
+}
+
+void FrameBitmap::clearRun(size_t first, size_t length)
+{
+    size_t from = first;
+    size_t to = first + length;
+    while (from < to) {
+        size_t w = from / WORD_BITS;
+        size_t wordEnd = std::min(to - w * WORD_BITS, WORD_BITS);
+        words[w] &= ~bitRange(from % WORD_BITS, wordEnd);
+        from = (w + 1) * WORD_BITS;
+    }
+    nFree -= length;
+}
+
+size_t FrameBitmap::countTrailingZeros(uint64_t word)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+size_t FrameBitmap::popCount(uint64_t word)
+{
+#ifdef _MSC_VER
+    return static_cast<size_t>(__popcnt64(word));
+#else
+    return __builtin_popcountll(word);
+#endif
+}
@@ -1,34 +0,0 @@
-#include <ctime>
-#include <memory>
-#include <string>
-#include <vector>
-#include <fstream>
-#include <iomanip>
-#include <sstream>
-#include <iostream>
-
-using namespace std;
-
-class ICommand
-{
-public:
-    enum CommandType
-    {
-        PRINT
-    };
-
-    ICommand(int pid, CommandType commandType)
-    {
-        Pid = pid;
-        this->commandType = commandType;
-    }
-
-    virtual void execute() = 0;
-    virtual void setCore(int core) = 0;
-
- 
-
-protected:
-    int Pid;
-    CommandType commandType;
-};
@@ -0,0 +1,116 @@
+#include "../include/InstructionSource.h"
+
+#include <algorithm>
+
+namespace {
+// PRINT text; the writer puts the process name in place of %s
+const uint16_t GREETING = Program::intern("Hello World From %s started.");
+const uint16_t VALUE_LABEL = Program::intern("Value from %s: ");
+
+// xorshift32: generation draws one word per statement, so it has to be cheap
+uint32_t nextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+}
+
+InstructionSource::InstructionSource(uint32_t seed, int length, int blockingPercent)
+    : seed(seed), length(length), blockingPercent(static_cast<uint32_t>(std::min(std::max(blockingPercent, 0), 100)))
+{
+}
+
+int InstructionSource::size() const
+{
+    return length;
+}
+
+const Program& InstructionSource::nextBlock(int remaining)
+{
+    blockIndex++;
+    uint32_t rng = (seed ^ (static_cast<uint32_t>(blockIndex) * 0x9E3779B9u)) | 1;  // xorshift state must not be 0
+    block.reset();
+    block.reserve(BLOCK_BUDGET);
+
+    int budget = std::min(BLOCK_BUDGET, remaining);
+    for (int used = 0; used < budget;) {
+        used += emitStatement(rng, budget - used, 0);
+    }
+    return block;
+}
+
+const Program& InstructionSource::currentBlock() const
+{
+    return block;
+}
+
+void InstructionSource::release()
+{
+    block.clear();
+}
+
+size_t InstructionSource::getFootprint() const
+{
+    return block.getFootprint();
+}
+
+int InstructionSource::emitStatement(uint32_t& rng, int budget, int depth)
+{
+    // One draw supplies the operands: two 5-bit variables and 10 bits of literal
+    uint32_t draw = nextRandom(rng);
+    uint16_t variable = static_cast<uint16_t>(draw % Program::VARIABLE_COUNT);
+    uint16_t other = static_cast<uint16_t>((draw >> 5) % Program::VARIABLE_COUNT);
+    uint16_t literal = static_cast<uint16_t>((draw >> 10) % 1000);
+
+    // A second draw makes the choices from separate decimal digits, so the configured share of
+    // blocking statements leaves the other choices their relative weights
+    uint32_t choice = nextRandom(rng);
+    if (choice % 100 < blockingPercent) {
+        if ((choice / 1000) % 2) {
+            block.emit(Program::SLEEP, static_cast<uint16_t>(1 + (draw >> 24) % 4));
+        } else {
+            block.emit(Program::IO, static_cast<uint16_t>(2 + (draw >> 24) % 8));
+        }
+        return 1;
+    }
+
+    switch ((choice / 100) % 10) {
+    case 0:
+    case 1: {
+        // FOR runs once and END once per iteration, around a body of one to three statements
+        int repeats = 2 + static_cast<int>((draw >> 24) % 3);
+        int bodyBudget = (budget - 1) / repeats - 1;
+        if (depth >= Program::MAX_LOOP_DEPTH || bodyBudget < 1) {
+            break;
+        }
+        block.emit(Program::FOR, static_cast<uint16_t>(repeats));
+        int bodyCost = 0;
+        int statements = 1 + static_cast<int>((draw >> 28) % 3);
+        for (int i = 0; i < statements && bodyCost < bodyBudget; ++i) {
+            bodyCost += emitStatement(rng, bodyBudget - bodyCost, depth + 1);
+        }
+        block.emit(Program::END);
+        return 1 + repeats * (bodyCost + 1);
+    }
+    case 2:
+        block.emit(Program::DECLARE, variable, literal, 0, Program::LITERAL_B);
+        return 1;
+    case 3:
+    case 4:
+    case 5:
+        block.emit(Program::ADD, variable, other, literal, Program::LITERAL_C);
+        return 1;
+    case 6:
+    case 7:
+        block.emit(Program::SUBTRACT, variable, variable, other);
+        return 1;
+    case 8:
+        block.emit(Program::PRINT, VALUE_LABEL, variable, 0, Program::HAS_B);
+        return 1;
+    }
+    // The remaining choices, and loops that do not fit, print the greeting
+    block.emit(Program::PRINT, GREETING);
+    return 1;
+}
@@ -0,0 +1,78 @@
+#include "../include/MemoryReclaimer.h"
+
+#include <algorithm>
+#include <iomanip>
+
+MemoryReclaimer::MemoryReclaimer(std::function<size_t()> freeAmount, std::function<bool()> reclaimOne)
+    : freeAmount(std::move(freeAmount)), reclaimOne(std::move(reclaimOne))
+{
+}
+
+MemoryReclaimer::~MemoryReclaimer()
+{
+    {
+        std::lock_guard<std::mutex> lock(reclaimMutex);
+        stopping = true;
+    }
+    reclaimCondition.notify_all();
+    if (reclaimThread.joinable()) {
+        reclaimThread.join();
+    }
+}
+
+void MemoryReclaimer::setWatermarks(size_t low, size_t high)
+{
+    lowWatermark = low;
+    highWatermark = std::max(low, high);
+
+    std::lock_guard<std::mutex> lock(reclaimMutex);
+    if (low > 0 && !reclaimThread.joinable()) {
+        reclaimThread = std::thread(&MemoryReclaimer::run, this);
+    }
+}
+
+void MemoryReclaimer::noteFree(size_t free)
+{
+    if (free >= lowWatermark) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(reclaimMutex);
+        woken = true;
+    }
+    reclaimCondition.notify_one();
+}
+
+void MemoryReclaimer::recordDirectReclaim()
+{
+    directReclaims++;
+}
+
+void MemoryReclaimer::run()
+{
+    std::unique_lock<std::mutex> lock(reclaimMutex);
+    for (;;) {
+        // The timeout catches memory that ran low without passing through noteFree
+        reclaimCondition.wait_for(lock, std::chrono::milliseconds(10), [this] { return stopping || woken; });
+        if (stopping) {
+            return;
+        }
+        woken = false;
+        lock.unlock();
+
+        if (freeAmount() < lowWatermark) {
+            wakeups++;
+            while (freeAmount() < highWatermark && reclaimOne()) {
+                backgroundReclaims++;
+            }
+        }
+        lock.lock();
+    }
+}
+
+void MemoryReclaimer::printStats(std::ostream& out) const
+{
+    out << std::setw(12) << directReclaims << " direct reclaims" << std::endl;
+    out << std::setw(12) << backgroundReclaims << " background reclaims" << std::endl;
+    out << std::setw(12) << wakeups << " reclaimer wakeups" << std::endl;
+}
@@ -0,0 +1,244 @@
+#include "../include/OutputLog.h"
+#include "../include/CPUClock.h"
+#include "../include/Program.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <tuple>
+
+OutputLog::OutputLog(CPUClock* cpuClock, const std::string& mode)
+    : cpuClock(cpuClock), singleLog(mode == "log")
+{
+    if (singleLog) {
+        log.open("process_output.log", std::ios::trunc);
+        index.open("process_output.idx", std::ios::trunc);
+    }
+    writerThread = std::thread(&OutputLog::run, this);
+}
+
+OutputLog::~OutputLog()
+{
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        stopping = true;
+    }
+    writerCondition.notify_all();
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+}
+
+void OutputLog::registerProcess(size_t pid, const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(namesMutex);
+    names[pid] = name;
+}
+
+void OutputLog::print(int core, size_t pid, uint32_t sequence, uint16_t message, uint16_t value, bool hasValue)
+{
+    Record record{pid, sequence, cpuClock->getCPUClock(), static_cast<int16_t>(core), message, value, hasValue};
+    Ring& ring = threadRing();
+    if (!ring.push(record)) {
+        nFullStalls++;
+        do {
+            wakeWriter();
+            std::this_thread::yield();
+        } while (!ring.push(record));
+    }
+    // Half full: start draining before the ring fills and prints have to wait
+    if (ring.size() == Ring::CAPACITY / 2) {
+        wakeWriter();
+    }
+}
+
+void OutputLog::flush()
+{
+    std::unique_lock<std::mutex> lock(writerMutex);
+    size_t request = ++flushRequests;
+    writerCondition.notify_all();
+    flushedCondition.wait(lock, [this, request] { return flushesDone >= request || stopping; });
+}
+
+void OutputLog::printStats(std::ostream& out) const
+{
+    out << std::setw(12) << nRecords << " process output records written" << std::endl;
+    out << std::setw(12) << nBatches << " process output batches" << std::endl;
+    out << std::setw(12) << nFullStalls << " process output full ring stalls" << std::endl;
+}
+
+OutputLog::Ring& OutputLog::threadRing()
+{
+    thread_local const OutputLog* owner = nullptr;
+    thread_local Ring* ring = nullptr;
+    if (owner != this) {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        rings.push_back(std::make_unique<Ring>());
+        ring = rings.back().get();
+        owner = this;
+    }
+    return *ring;
+}
+
+void OutputLog::wakeWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        woken = true;
+    }
+    writerCondition.notify_one();
+}
+
+void OutputLog::run()
+{
+    std::vector<Record> batch;
+    std::unique_lock<std::mutex> lock(writerMutex);
+    for (;;) {
+        // The timeout bounds how long a quiet process's output waits to be written
+        writerCondition.wait_for(lock, std::chrono::milliseconds(10),
+                                 [this] { return stopping || woken || flushesDone < flushRequests; });
+        woken = false;
+        bool stop = stopping;
+        size_t flushing = flushRequests;
+        lock.unlock();
+
+        batch.swap(heldBack);
+        {
+            std::lock_guard<std::mutex> ringsLock(ringsMutex);
+            for (std::unique_ptr<Ring>& ring : rings) {
+                ring->drainTo(batch);
+            }
+        }
+        if (!batch.empty()) {
+            writeBatch(batch);
+            batch.clear();
+        }
+
+        lock.lock();
+        flushesDone = flushing;
+        flushedCondition.notify_all();
+        if (stop) {
+            return;
+        }
+    }
+}
+
+void OutputLog::writeBatch(std::vector<Record>& batch)
+{
+    // Rings are drained one after another, so a process that changed threads can have a later
+    // record in this batch while an earlier one is still in a ring drained before it was printed
+    std::sort(batch.begin(), batch.end(), [](const Record& a, const Record& b) {
+        return std::tie(a.pid, a.tick, a.sequence) < std::tie(b.pid, b.tick, b.sequence);
+    });
+
+    size_t written = 0;
+    for (size_t first = 0; first < batch.size();) {
+        size_t end = first;
+        while (end < batch.size() && batch[end].pid == batch[first].pid) {
+            end++;
+        }
+
+        // Only the run that continues the process's output is written; the rest waits for its gap
+        uint32_t& next = nextSequence[batch[first].pid];
+        size_t last = first;
+        while (last < end && batch[last].sequence == next) {
+            last++;
+            next++;
+        }
+        heldBack.insert(heldBack.end(), batch.begin() + last, batch.begin() + end);
+        if (last == first) {
+            first = end;
+            continue;
+        }
+        written += last - first;
+
+        std::string name;
+        {
+            std::lock_guard<std::mutex> lock(namesMutex);
+            auto it = names.find(batch[first].pid);
+            name = it != names.end() ? it->second : std::to_string(batch[first].pid);
+        }
+
+        // The group is formatted into one buffer and written with a single call
+        std::string buffer;
+        std::vector<std::pair<uint16_t, std::string>> texts;  // Messages of this group with the name filled in
+        for (size_t i = first; i < last; ++i) {
+            const Record& record = batch[i];
+            auto text = std::find_if(texts.begin(), texts.end(), [&record](const auto& entry) { return entry.first == record.message; });
+            if (text == texts.end()) {
+                texts.emplace_back(record.message, expand(record.message, name));
+                text = texts.end() - 1;
+            }
+            if (singleLog) {
+                buffer += name;
+                buffer += ' ';
+            }
+            appendLine(buffer, record, text->second);
+        }
+
+        if (singleLog) {
+            index << batch[first].pid << ' ' << name << ' ' << log.tellp() << ' ' << last - first << '\n';
+            log.write(buffer.data(), buffer.size());
+        } else {
+            std::ofstream out(name + ".txt", std::ios::app);
+            out.write(buffer.data(), buffer.size());
+        }
+        first = end;
+    }
+    if (singleLog) {
+        log.flush();
+        index.flush();
+    }
+    nRecords += written;
+    nBatches++;
+}
+
+std::string OutputLog::expand(uint16_t message, const std::string& name)
+{
+    std::string text = Program::getString(message);
+    size_t placeholder = text.find("%s");
+    if (placeholder != std::string::npos) {
+        text.replace(placeholder, 2, name);
+    }
+    return text;
+}
+
+// (tick 1234) Core:3 "Value from p01: 17" -- the tick stands in for a wall-clock timestamp
+void OutputLog::appendLine(std::string& buffer, const Record& record, const std::string& text)
+{
+    buffer += "(tick ";
+    buffer += std::to_string(record.tick);
+    buffer += ") Core:";
+    buffer += std::to_string(record.core);
+    buffer += " \"";
+    buffer += text;
+    if (record.hasValue) {
+        buffer += std::to_string(record.value);
+    }
+    buffer += "\"\n";
+}
+
+bool OutputLog::Ring::push(const Record& record)
+{
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == CAPACITY) {
+        return false;
+    }
+    slots[t & (CAPACITY - 1)] = record;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+size_t OutputLog::Ring::size() const
+{
+    return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_relaxed);
+}
+
+void OutputLog::Ring::drainTo(std::vector<Record>& batch)
+{
+    size_t h = head.load(std::memory_order_relaxed);
+    size_t t = tail.load(std::memory_order_acquire);
+    for (; h != t; ++h) {
+        batch.push_back(slots[h & (CAPACITY - 1)]);
+    }
+    head.store(t, std::memory_order_release);
+}
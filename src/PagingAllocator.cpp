@@ -1,5 +1,6 @@
 #include "../include/PagingAllocator.h"
 #include "../include/Process.h"
+#include <cassert>
 #include <iostream> 
 #include <fstream>  
 #include <ctime>  
@@ -9,63 +10,90 @@
 #include <iomanip>  // For std::put_time
 #include <memory>
 #include <algorithm>
+#include <sstream>
+#include <thread>
 
 PagingAllocator::PagingAllocator(size_t maximumSize, size_t mem_per_frame) 
     : maximumSize(maximumSize), 
       numFrames(static_cast<size_t>(std::ceil(static_cast<double>(maximumSize) / mem_per_frame))), 
-      mem_per_frame(mem_per_frame), 
-      nProcess(0), nPagedIn(0), nPagedOut(0) {
+      frameTable(numFrames, FrameEntry{nullptr, 0, 0, 0}), freeFrames(numFrames), contiguousPlacement(false),
+      referenceBits(new std::atomic<uint64_t>[(numFrames + 63) / 64]()), nReferenceWords((numFrames + 63) / 64),
+      hugeFrameMultiple(1),
+      nFreeFrames(numFrames), nPagedIn(0), nPagedOut(0), nMinorFaults(0), nMajorFaults(0), nFaultCycles(0),
+      minorFaultCycles(1), majorFaultCycles(10),
+      mem_per_frame(mem_per_frame), memory(numFrames * mem_per_frame, '.'), nProcess(0),
+      backingStore("backingstore.bin", mem_per_frame, numFrames),
+      reclaimer([this] { return nFreeFrames.load(); },
+                [this] { return reclaimFrame(); }) {
+
+    replacementPolicy = createReplacementPolicy("fifo", 0);
+}
+
+bool PagingAllocator::backedByHugeFrames(const Process& process) const {
+    return hugeFrameMultiple > 1 && process.getNumPages() >= hugeFrameMultiple;
+}
 
-    for (size_t i = 0; i < numFrames; ++i) {
-        freeFrameList.push_back(i);
+// Memory is rounded up to whole pages of the size that backs the process, so a huge-backed
+// process wastes the tail of its last huge frame even if that tail falls back to base frames
+size_t PagingAllocator::internalFragmentation(const Process& process) const {
+    size_t frames = process.getNumPages();
+    if (backedByHugeFrames(process)) {
+        frames = (frames + hugeFrameMultiple - 1) / hugeFrameMultiple * hugeFrameMultiple;
     }
+    return frames * mem_per_frame - process.getMemoryRequired();
 }
 
 void* PagingAllocator::allocate(std::shared_ptr<Process> process) {
-    std::lock_guard<std::mutex> lock(memoryMutex);
+    TimedLock lock(*this);
     size_t numFramesNeeded = process->getNumPages();
-    if(numFramesNeeded > freeFrameList.size()){
-        return nullptr;
+
+    // Demand paging: only the page table is set up, frames come with the first touch of each page.
+    // Contiguous placement maps every page up front when a long enough run of frames is free.
+    std::vector<PageEntry>& pageTable = pageTables[process->getPID()];
+    pageTable.assign(numFramesNeeded, PageEntry{NO_FRAME, BackingStore::NO_SLOT});
+    if (contiguousPlacement) {
+        mapContiguous(*process, pageTable);
     }
-    
-    size_t frameIndex = allocateFrames(numFramesNeeded, process);
     processList[process->getPID()] = process;
     nProcess++;
-    return reinterpret_cast<void*>(frameIndex);
+    if (backedByHugeFrames(*process)) {
+        sizeClassStats[HUGE_FRAME].pageTableEntries += (numFramesNeeded + hugeFrameMultiple - 1) / hugeFrameMultiple;
+        sizeClassStats[HUGE_FRAME].internalFragmentation += internalFragmentation(*process);
+    } else {
+        sizeClassStats[BASE_FRAME].pageTableEntries += numFramesNeeded;
+        sizeClassStats[BASE_FRAME].internalFragmentation += internalFragmentation(*process);
+    }
+    pinnedProcesses.insert(process->getPID());  // Dispatched right after allocation
+    // The page table's address is stable until deallocate and never null, unlike a frame number
+    process->setMemory(&pageTable);
+    assert(checkFrameConservation());
+    return reinterpret_cast<void*>(&pageTable);
 }
 
 void PagingAllocator::deallocate(std::shared_ptr<Process> process) {
-    std::lock_guard<std::mutex> lock(memoryMutex);
-    processList.erase(process->getPID());
-    nProcess--;
-
-    auto it = std::find_if(frameMap.begin(), frameMap.end(), [process](const auto& entry) { return entry.second == process; });
-
-    while (it != frameMap.end()) {
-        size_t frameIndex = it->first;
-        deallocateFrames(1, frameIndex);
-        it = std::find_if(frameMap.begin(), frameMap.end(), [process](const auto& entry) { return entry.second == process; });
+    TimedLock lock(*this);
+    auto it = pageTables.find(process->getPID());
+    if (it == pageTables.end()) {
+        return;
     }
 
-    // std::cout << "test " << frameMap.size() << std::endl;
-
-    // Ensure that the total frames in freeFrameList and frameMap are equal to numFrames
-    size_t totalAllocatedFrames = frameMap.size();
-    size_t totalFreeFrames = freeFrameList.size();
-
-    // Check if the total allocated and free frames equal numFrames
-    if (totalAllocatedFrames + totalFreeFrames != numFrames) {
-        size_t missingFrames = numFrames - (totalAllocatedFrames + totalFreeFrames);
-        if (missingFrames > 0) {
-            // Add missing frames back to freeFrameList
-            for (size_t i = 0; i < missingFrames; ++i) {
-                freeFrameList.push_back(numFrames + i);  // Add new frames beyond numFrames
-            }
-
-            
-
-        } 
+    // Frames go back before the lock is released, so a fault that finds nothing to evict
+    // never misses them
+    releaseFrames(it->second, process->getCPUCoreID());
+    pageTables.erase(it);
+    process->adjustResidentPages(-static_cast<int>(process->getResidentPages()));
+    processList.erase(process->getPID());
+    pinnedProcesses.erase(process->getPID());
+    process->setMemory(nullptr);
+    nProcess--;
+    if (backedByHugeFrames(*process)) {
+        sizeClassStats[HUGE_FRAME].pageTableEntries -= (process->getNumPages() + hugeFrameMultiple - 1) / hugeFrameMultiple;
+        sizeClassStats[HUGE_FRAME].internalFragmentation -= internalFragmentation(*process);
+    } else {
+        sizeClassStats[BASE_FRAME].pageTableEntries -= process->getNumPages();
+        sizeClassStats[BASE_FRAME].internalFragmentation -= internalFragmentation(*process);
     }
+    assert(checkFrameConservation());
 }
 
 
@@ -74,14 +102,11 @@ void PagingAllocator::visualizeMemory() {
     std::cout << "Memory Visualization:\n";
 
     for (size_t frameIndex = 0; frameIndex < numFrames; ++frameIndex) {
-        // Search for the frame in the map
-        auto it = frameMap.find(frameIndex);
-
-        if (it != frameMap.end()) {
-            // If the frame is found, print the frame and the associated process
-            std::cout << "Frame " << frameIndex << " -> Process " << it->second << "\n";
+        const FrameEntry& frame = frameTable[frameIndex];
+        if (frame.owner) {
+            std::cout << "Frame " << frameIndex << " -> Process " << frame.owner->getPID() << " page " << frame.page
+                      << (frameTable[frame.head].length > 1 ? " (huge)" : "") << "\n";
         } else {
-            // If the frame is not found, it means it's free
             std::cout << "Frame " << frameIndex << " -> Free\n";
         }
     }
@@ -90,121 +115,582 @@ void PagingAllocator::visualizeMemory() {
 
 
 int PagingAllocator::getNProcess() {
-    std::lock_guard<std::mutex> lock(memoryMutex);  // Lock mutex for thread-safe access
     return nProcess;
 }
 
 std::map<size_t, std::shared_ptr<Process>> PagingAllocator::getProcessList() {
-    std::lock_guard<std::mutex> lock(memoryMutex);  // Lock mutex for thread-safe access
+    TimedLock lock(*this);  // Lock mutex for thread-safe access
     return processList;
 }
 
 size_t PagingAllocator::getMaxMemory() {
-    std::lock_guard<std::mutex> lock(memoryMutex);  // Lock mutex for thread-safe access
+    TimedLock lock(*this);  // Lock mutex for thread-safe access
     return maximumSize;
 }
 
 size_t PagingAllocator::getExternalFragmentation() {
-    std::lock_guard<std::mutex> lock(memoryMutex);
-    return freeFrameList.size() * mem_per_frame;
+    return nFreeFrames * mem_per_frame;
+}
+
+// Frames need not be contiguous, so all free memory can back a single request
+size_t PagingAllocator::getLargestFreeBlock() {
+    return getExternalFragmentation();
+}
+
+size_t PagingAllocator::getFreeBlockCount() {
+    return nFreeFrames;
 }
 
 
 
-void PagingAllocator::deallocateOldest(size_t memSize) {
-    // Set the initial oldest time to the maximum possible time_point value
-    std::chrono::time_point<std::chrono::system_clock> oldestTime = std::chrono::time_point<std::chrono::system_clock>::max();
-    size_t oldestIndex = 0;  // To track the index of the oldest process
-    std::shared_ptr<Process> oldestProcess = nullptr;  // To store the oldest process
+// The victim gives up every frame it holds, so the request size does not matter
+bool PagingAllocator::deallocateOldest(size_t /*memSize*/) {
+    std::shared_ptr<Process> victimProcess = nullptr;  // Chosen by the replacement policy
+    {
+        TimedLock lock(*this);
+        // The process owning the victim frame gives up all of its frames. Running processes
+        // are skipped: their pages would only fault straight back in.
+        sampleReferences();
+        size_t victim = replacementPolicy->evict([this](size_t frameIndex) {
+            return frameTable[frameIndex].owner && !pinnedProcesses.count(frameTable[frameIndex].owner->getPID());
+        });
+        if (victim == ReplacementPolicy::NONE) {
+            return false;
+        }
+        auto it = processList.find(frameTable[victim].owner->getPID());
+        if (it == processList.end()) {
+            return false;
+        }
+        victimProcess = it->second;
+
+        // The process keeps its page table; every resident page goes to the backing store
+        // and faults back in when the process runs again. A huge frame goes with its first page.
+        for (PageEntry& entry : pageTables.find(victimProcess->getPID())->second) {
+            if (entry.frame != NO_FRAME) {
+                size_t head = entry.frame;
+                replacementPolicy->release(head);
+                freeMapping(head, swapOutMapping(head));
+                putFreeFrame(-1, head);
+            }
+        }
+        assert(checkFrameConservation());
+    }
+    backingStore.logSwapOut(*victimProcess, "Swapped out all resident pages");
+    return true;
+}
+
+// The page table is the process's memory handle and does not move while the process runs,
+// so a hit is a lock-free read of its entry. A hit racing with the eviction of its frame
+// counts one touch of a page that is just leaving, which the next touch faults back in.
+int PagingAllocator::accessPage(Process& process, size_t page){
+    std::vector<PageEntry>* pageTable = static_cast<std::vector<PageEntry>*>(process.getMemory());
+    if (!pageTable || page >= pageTable->size()) {
+        return 0;
+    }
+    size_t frameIndex = (*pageTable)[page].frame.load(std::memory_order_acquire);
+    if (frameIndex == NO_FRAME) {
+        return fault(process, *pageTable, page);
+    }
+
+    // Testing first keeps hot pages from writing the shared word on every touch
+    std::atomic<uint64_t>& word = referenceBits[frameIndex / 64];
+    uint64_t bit = uint64_t(1) << (frameIndex % 64);
+    if (!(word.load(std::memory_order_relaxed) & bit)) {
+        word.fetch_or(bit, std::memory_order_relaxed);
+    }
+    countHit(process.getCPUCoreID());
+    return 0;
+}
 
-    // Iterate through the process list to find the oldest process
-    for (const auto &pair : processList) {
-        size_t index = pair.first;
-        std::shared_ptr<Process> process = pair.second;
+void PagingAllocator::countHit(int core){
+    if (core >= 0 && static_cast<size_t>(core) < frameCaches.size()) {
+        std::atomic<size_t>& hits = frameCaches[core]->hits;
+        hits.store(hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    } else {
+        nUncachedHits.fetch_add(1, std::memory_order_relaxed);
+    }
+}
 
-        // Get the allocation time of the process
-        std::chrono::time_point<std::chrono::system_clock> allocTime = process->getAllocTime();
+void PagingAllocator::sampleReferences(){
+    size_t hits = nUncachedHits;
+    for (std::unique_ptr<FrameCache>& cache : frameCaches) {
+        hits += cache->hits.load(std::memory_order_relaxed);
+    }
+    replacementPolicy->addHits(hits - nSampledHits);
+    nSampledHits = hits;
 
-        // Check if this process has the oldest allocation time and meets the memory requirements
-        if (allocTime < oldestTime) {
-            oldestTime = allocTime;
-            oldestIndex = index;
-            oldestProcess = process;
+    for (size_t w = 0; w < nReferenceWords; ++w) {
+        if (referenceBits[w].load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        for (uint64_t bits = referenceBits[w].exchange(0, std::memory_order_relaxed); bits; bits &= bits - 1) {
+            const FrameEntry& frame = frameTable[w * 64 + FrameBitmap::countTrailingZeros(bits)];
+            if (frame.owner) {
+                replacementPolicy->reference(frame.head);
+            }
         }
     }
-   
+}
+
+// Only the faulting process maps its own pages, so the entry is still empty under the lock
+int PagingAllocator::fault(Process& process, std::vector<PageEntry>& pageTable, size_t page){
+    int core = process.getCPUCoreID();
+    bool hugeBacked = backedByHugeFrames(process);
 
-    // Now, oldestProcess holds the process with the oldest allocation time
-    if (oldestProcess) {
-        while(oldestProcess->getState() == Process::ProcessState::RUNNING){
-            //wait until its not running
+    bool major = false;
+    int cycles;
+    for (bool retry = false;; retry = true) {
+        if (retry) {
+            std::this_thread::yield();
         }
-        
-        // Log the deallocation info to a backing store file
-        std::ofstream backingStore("backingstore.txt", std::ios::app);  // Open file in append mode
+        size_t spare = hugeBacked ? NO_FRAME : takeFreeFrame(core);
+        TimedLock lock(*this);
+        // A page that was evicted has to come back from the backing store
+        bool huge = hugeBacked && mapHugeFrame(process, pageTable, page, major);
+        if (!huge) {
+            size_t frameIndex = spare != NO_FRAME ? spare : takeFrame(core);
+            if (frameIndex == NO_FRAME) {
+                continue;  // Every frame is another fault's spare, mapped once the lock is free
+            }
+            if (hugeBacked) {
+                nHugeFallbacks++;
+            }
+            PageEntry& entry = pageTable[page];
+            char* frameData = &memory[frameIndex * mem_per_frame];
+            major = entry.slot != BackingStore::NO_SLOT;
+            if (major) {
+                backingStore.read({entry.slot}, frameData, mem_per_frame);
+                backingStore.release({entry.slot});
+                entry.slot = BackingStore::NO_SLOT;
+            } else {
+                std::fill(frameData, frameData + mem_per_frame, 0);
+            }
+            referenceBits[frameIndex / 64].fetch_and(~(uint64_t(1) << (frameIndex % 64)), std::memory_order_relaxed);
+            frameTable[frameIndex] = FrameEntry{&process, page, frameIndex, 1};
+            entry.frame.store(frameIndex, std::memory_order_release);
+            nFramesInTransit--;
+            replacementPolicy->load(frameIndex);
+            process.adjustResidentPages(1);
+            nPagedIn++;
+            sizeClassStats[BASE_FRAME].pagedIn++;
+        }
+
+        cycles = major ? majorFaultCycles : minorFaultCycles;
+        if (major) {
+            nMajorFaults++;
+        } else {
+            nMinorFaults++;
+        }
+        nFaultCycles += cycles;
+        break;
+    }
+    process.recordPageFault(major, cycles);
+    reclaimer.noteFree(nFreeFrames);
+    return cycles;
+}
+
+size_t PagingAllocator::takeFrame(int core){
+    size_t frameIndex = takeFreeFrame(core);
+    if (frameIndex != NO_FRAME) {
+        return frameIndex;
+    }
 
-       if (backingStore.is_open()) {
-            // Convert the allocation time to a human-readable format
-            std::time_t allocTime_t = std::chrono::system_clock::to_time_t(oldestProcess->getAllocTime());
-            std::tm allocTime_tm;
+    // The replacement policy gives up a resident frame. The rest of an evicted huge frame
+    // stays free for the faults after this one. There is none when every frame is a spare
+    // other faults took before waiting for the lock.
+    sampleReferences();
+    frameIndex = replacementPolicy->evict();
+    if (frameIndex == ReplacementPolicy::NONE) {
+        return NO_FRAME;
+    }
+    freeMapping(frameIndex, swapOutMapping(frameIndex));
+    reclaimer.recordDirectReclaim();
+    return frameIndex;
+}
 
-            // Use localtime_s for thread safety
-            if (localtime_s(&allocTime_tm, &allocTime_t) == 0) { // Check for success
-                // Write the deallocation log
-                backingStore << "Process ID: " << oldestProcess->getPID();
-                backingStore << "  Name: " << oldestProcess->getName();
-                backingStore << "  Command Counter: " << oldestProcess->getCommandCounter()
-                    << "/" << oldestProcess->getLinesOfCode() << "\n";
-                backingStore << "Memory Size: " << oldestProcess->getMemoryRequired() << " KB\n";
-                backingStore << "Num Pages: " << oldestProcess->getNumPages() << "\n";
-                backingStore << "============================================================================\n";
+bool PagingAllocator::reclaimFrame(){
+    TimedLock lock(*this);
+    sampleReferences();
+    size_t frameIndex = replacementPolicy->evict();
+    if (frameIndex == ReplacementPolicy::NONE) {
+        return false;
+    }
+    freeMapping(frameIndex, swapOutMapping(frameIndex));
+    putFreeFrame(-1, frameIndex);
+    assert(checkFrameConservation());
+    return true;
+}
 
-                backingStore.close();
+size_t PagingAllocator::takeFreeFrame(int core){
+    FrameCache* cache = (core >= 0 && static_cast<size_t>(core) < frameCaches.size()) ? frameCaches[core].get() : nullptr;
+    if (cache) {
+        std::lock_guard<std::mutex> cacheLock(cache->mutex);
+        if (cache->frames.empty()) {
+            std::lock_guard<std::mutex> listLock(freeListMutex);
+            for (size_t i = 0; i < FRAME_CACHE_BATCH; ++i) {
+                size_t frameIndex = freeFrames.takeAny();
+                if (frameIndex == FrameBitmap::NONE) {
+                    break;
+                }
+                cache->frames.push_back(frameIndex);
             }
-            else {
-                // Handle the error if localtime_s fails
-                std::cerr << "Failed to convert time to local time format." << std::endl;
+            if (!cache->frames.empty()) {
+                nCacheRefills++;
+            }
+        }
+        if (!cache->frames.empty()) {
+            size_t frameIndex = cache->frames.back();
+            cache->frames.pop_back();
+            nFreeFrames--;
+            nFramesInTransit++;
+            return frameIndex;
+        }
+    } else {
+        std::lock_guard<std::mutex> listLock(freeListMutex);
+        size_t frameIndex = freeFrames.takeAny();
+        if (frameIndex != FrameBitmap::NONE) {
+            nFreeFrames--;
+            nFramesInTransit++;
+            return frameIndex;
+        }
+    }
+
+    // The shared set is empty, but other cores may still cache free frames
+    for (std::unique_ptr<FrameCache>& other : frameCaches) {
+        if (other.get() == cache) {
+            continue;
+        }
+        std::lock_guard<std::mutex> otherLock(other->mutex);
+        if (!other->frames.empty()) {
+            size_t frameIndex = other->frames.back();
+            other->frames.pop_back();
+            nFreeFrames--;
+            nFramesInTransit++;
+            return frameIndex;
+        }
+    }
+    return NO_FRAME;
+}
+
+void PagingAllocator::putFreeFrame(int core, size_t frameIndex){
+    if (core >= 0 && static_cast<size_t>(core) < frameCaches.size()) {
+        FrameCache& cache = *frameCaches[core];
+        std::lock_guard<std::mutex> cacheLock(cache.mutex);
+        cache.frames.push_back(frameIndex);
+        nFreeFrames++;
+        nFramesInTransit--;
+        // Keep one batch for the core's next faults and give the rest back
+        if (cache.frames.size() > 2 * FRAME_CACHE_BATCH) {
+            std::lock_guard<std::mutex> listLock(freeListMutex);
+            for (size_t i = FRAME_CACHE_BATCH; i < cache.frames.size(); ++i) {
+                freeFrames.release(cache.frames[i]);
             }
+            cache.frames.resize(FRAME_CACHE_BATCH);
+            nCacheDrains++;
         }
+        return;
+    }
+    std::lock_guard<std::mutex> listLock(freeListMutex);
+    nFramesInTransit--;
+    if (freeFrames.release(frameIndex)) {
+        nFreeFrames++;
+    } else {
+        std::cerr << "Error: Frame " << frameIndex << " freed while already free" << std::endl;
+    }
+}
 
+// Maps every page of a new process into one run of frames, as if each had just faulted in
+bool PagingAllocator::mapContiguous(Process& process, std::vector<PageEntry>& pageTable){
+    size_t first;
+    {
+        std::lock_guard<std::mutex> listLock(freeListMutex);
+        first = freeFrames.takeRun(pageTable.size());
+    }
+    if (first == FrameBitmap::NONE) {
+        return false;
+    }
+    nFreeFrames -= pageTable.size();
+
+    for (size_t page = 0; page < pageTable.size(); ++page) {
+        size_t frameIndex = first + page;
+        std::fill(&memory[frameIndex * mem_per_frame], &memory[frameIndex * mem_per_frame] + mem_per_frame, 0);
+        referenceBits[frameIndex / 64].fetch_and(~(uint64_t(1) << (frameIndex % 64)), std::memory_order_relaxed);
+        pageTable[page].frame = frameIndex;
+        frameTable[frameIndex] = FrameEntry{&process, page, frameIndex, 1};
+        replacementPolicy->load(frameIndex);
+    }
+    process.adjustResidentPages(static_cast<int>(pageTable.size()));
+    nPagedIn += pageTable.size();
+    sizeClassStats[BASE_FRAME].pagedIn += pageTable.size();
+    nContiguousAllocations++;
+    return true;
+}
 
-        if(oldestProcess->getState() != Process::ProcessState::FINISHED){
-            // Perform the deallocation
-            deallocate(oldestProcess);
-            oldestProcess->setMemory(nullptr);
+// Faults in the aligned group of pages holding page as one huge frame. Pages past the end of
+// the page table still get frames, already counted as internal fragmentation at allocation.
+bool PagingAllocator::mapHugeFrame(Process& process, std::vector<PageEntry>& pageTable, size_t page, bool& major){
+    size_t first = page - page % hugeFrameMultiple;
+    size_t end = std::min(first + hugeFrameMultiple, pageTable.size());
+    for (size_t p = first; p < end; ++p) {
+        if (pageTable[p].frame != NO_FRAME) {
+            return false;  // Part of the group already sits in base frames
+        }
+    }
+    size_t head;
+    {
+        std::lock_guard<std::mutex> listLock(freeListMutex);
+        head = freeFrames.takeRun(hugeFrameMultiple, hugeFrameMultiple);
+    }
+    if (head == FrameBitmap::NONE) {
+        return false;
+    }
+    nFreeFrames -= hugeFrameMultiple;
+
+    for (size_t i = 0; i < hugeFrameMultiple; ++i) {
+        size_t frameIndex = head + i;
+        char* frameData = &memory[frameIndex * mem_per_frame];
+        if (first + i < end && pageTable[first + i].slot != BackingStore::NO_SLOT) {
+            PageEntry& entry = pageTable[first + i];
+            backingStore.read({entry.slot}, frameData, mem_per_frame);
+            backingStore.release({entry.slot});
+            entry.slot = BackingStore::NO_SLOT;
+            major = true;
+        } else {
+            std::fill(frameData, frameData + mem_per_frame, 0);
+        }
+        referenceBits[frameIndex / 64].fetch_and(~(uint64_t(1) << (frameIndex % 64)), std::memory_order_relaxed);
+        if (first + i < end) {
+            pageTable[first + i].frame = frameIndex;
         }
+        frameTable[frameIndex] = FrameEntry{&process, first + i, head, i == 0 ? hugeFrameMultiple : 0};
+    }
+    replacementPolicy->load(head);
+    process.adjustResidentPages(static_cast<int>(hugeFrameMultiple));
+    nPagedIn += end - first;
+    sizeClassStats[HUGE_FRAME].pagedIn += end - first;
+    return true;
+}
 
+void PagingAllocator::freeMapping(size_t head, size_t length){
+    for (size_t frameIndex = head + 1; frameIndex < head + length; ++frameIndex) {
+        putFreeFrame(-1, frameIndex);
     }
 }
 
-size_t PagingAllocator::allocateFrames(size_t numFrame, std::shared_ptr<Process> process){
-    size_t frameIndex = freeFrameList.back(); 
-    // Map allocated frames to the process ID 
-    for (size_t i = 0; i < numFrame; ++i) {
-        freeFrameList.pop_back();
-        frameMap [frameIndex + i] = process;
-        nPagedIn++;
+// Faults move frames between the caches without memoryMutex, so every cache and the shared
+// set are held at once for a consistent count. No one else holds two caches, so taking them
+// in order cannot deadlock.
+bool PagingAllocator::checkFrameConservation(){
+    std::vector<std::unique_lock<std::mutex>> cacheLocks;
+    size_t cached = 0;
+    for (std::unique_ptr<FrameCache>& cache : frameCaches) {
+        cacheLocks.emplace_back(cache->mutex);
+        cached += cache->frames.size();
     }
-    return frameIndex;
+    std::lock_guard<std::mutex> listLock(freeListMutex);
+    size_t free = freeFrames.countSlow();
+    size_t counted = freeFrames.count();
+    size_t inTransit = nFramesInTransit;
+    size_t resident = 0;
+    for (const FrameEntry& frame : frameTable) {
+        if (frame.owner) {
+            resident++;
+        }
+    }
+
+    if (free != counted || free + cached != nFreeFrames || free + cached + resident + inTransit != numFrames) {
+        std::cerr << "Error: Frame conservation violated: " << free << " free (" << counted << " counted) + "
+                  << cached << " cached + " << resident << " resident + " << inTransit << " in transit != "
+                  << numFrames << " frames" << std::endl;
+        return false;
+    }
+    return true;
 }
 
-void PagingAllocator::deallocateFrames(size_t numFrame, size_t frameIndex){
-    for (size_t i = 0 ; i < numFrame; ++i) { 
-        frameMap.erase (frameIndex + i);
-        nPagedOut++;
+size_t PagingAllocator::swapOutMapping(size_t head){
+    size_t length = frameTable[head].length;
+    SizeClass sizeClass = length > 1 ? HUGE_FRAME : BASE_FRAME;
+    Process* owner = frameTable[head].owner;
+    std::vector<PageEntry>& pageTable = pageTables.find(owner->getPID())->second;
+    for (size_t frameIndex = head; frameIndex < head + length; ++frameIndex) {
+        FrameEntry& victim = frameTable[frameIndex];
+        if (victim.page < pageTable.size()) {
+            PageEntry& entry = pageTable[victim.page];
+            entry.frame = NO_FRAME;
+            entry.slot = backingStore.write(&memory[frameIndex * mem_per_frame], mem_per_frame).front();
+            nPagedOut++;
+            sizeClassStats[sizeClass].pagedOut++;
+        }
+        victim = FrameEntry{nullptr, 0, 0, 0};
+        nFramesInTransit++;
     }
-    // Add frames back to the free frame list
-    for (size_t i = 0; i < numFrame; ++i) {
-       freeFrameList.push_back(frameIndex + i);
+    owner->adjustResidentPages(-static_cast<int>(length));
+    return length;
+}
+
+void PagingAllocator::releaseFrames(std::vector<PageEntry>& pageTable, int core){
+    for (PageEntry& entry : pageTable) {
+        if (entry.frame != NO_FRAME) {
+            // Every page of a huge frame is released with its first one, which comes first in the table
+            size_t head = entry.frame;
+            size_t length = frameTable[head].length;
+            replacementPolicy->release(head);
+            for (size_t frameIndex = head; frameIndex < head + length; ++frameIndex) {
+                // Nothing is written back, so an exiting process's pages are not paged out
+                size_t page = frameTable[frameIndex].page;
+                if (page < pageTable.size()) {
+                    pageTable[page].frame = NO_FRAME;
+                }
+                frameTable[frameIndex] = FrameEntry{nullptr, 0, 0, 0};
+                nFramesInTransit++;
+                // Huge frames go back to the shared set whole, where the next huge fault can find them
+                putFreeFrame(length > 1 ? -1 : core, frameIndex);
+            }
+        }
+        if (entry.slot != BackingStore::NO_SLOT) {
+            backingStore.release({entry.slot});
+        }
     }
+    pageTable.clear();
 }
 
 size_t PagingAllocator::getPageIn(){
-    std::lock_guard<std::mutex> lock(memoryMutex); 
     return nPagedIn;
 }
 size_t PagingAllocator::getPageOut(){
-    std::lock_guard<std::mutex> lock(memoryMutex); 
     return nPagedOut;
 }
+size_t PagingAllocator::getInternalFragmentation(){
+    return sizeClassStats[BASE_FRAME].internalFragmentation + sizeClassStats[HUGE_FRAME].internalFragmentation;
+}
+void PagingAllocator::printStats(std::ostream& out){
+    // Lock times are read first so this call's own acquisition is not part of them
+    size_t acquisitions = nLockAcquisitions;
+    std::ostringstream wait, hold;
+    wait << std::fixed << std::setprecision(2) << (acquisitions ? lockWaitNanos / 1000.0 / acquisitions : 0.0);
+    hold << std::fixed << std::setprecision(2) << (acquisitions ? lockHoldNanos / 1000.0 / acquisitions : 0.0);
+
+    TimedLock lock(*this);
+    checkFrameConservation();
+    sampleReferences();
+    size_t faults = nMinorFaults + nMajorFaults;
+    std::ostringstream latency;
+    latency << std::fixed << std::setprecision(2) << (faults ? static_cast<double>(nFaultCycles) / faults : 0.0);
+    out << std::setw(12) << nMinorFaults << " minor page faults" << std::endl;
+    out << std::setw(12) << nMajorFaults << " major page faults" << std::endl;
+    out << std::setw(12) << latency.str() << " cycles avg fault latency" << std::endl;
+    out << std::setw(12) << nCacheRefills << " frame cache refills" << std::endl;
+    out << std::setw(12) << nCacheDrains << " frame cache drains" << std::endl;
+    out << std::setw(12) << nContiguousAllocations << " contiguous allocations" << std::endl;
+    const char* classNames[NUM_SIZE_CLASSES] = {"base", "huge"};
+    for (int sizeClass = BASE_FRAME; sizeClass < NUM_SIZE_CLASSES; ++sizeClass) {
+        const SizeClassStats& stats = sizeClassStats[sizeClass];
+        out << std::setw(12) << stats.pageTableEntries << " " << classNames[sizeClass] << " page table entries" << std::endl;
+        out << std::setw(12) << stats.internalFragmentation << " KB " << classNames[sizeClass] << " internal fragmentation" << std::endl;
+        out << std::setw(12) << stats.pagedIn << " " << classNames[sizeClass] << " pages paged in" << std::endl;
+        out << std::setw(12) << stats.pagedOut << " " << classNames[sizeClass] << " pages paged out" << std::endl;
+    }
+    out << std::setw(12) << nHugeFallbacks << " huge frame fallbacks" << std::endl;
+    replacementPolicy->printStats(out);
+    reclaimer.printStats(out);
+    out << std::setw(12) << acquisitions << " allocator lock acquisitions" << std::endl;
+    out << std::setw(12) << nContendedAcquisitions << " contended allocator lock acquisitions" << std::endl;
+    out << std::setw(12) << wait.str() << " us avg allocator lock wait" << std::endl;
+    out << std::setw(12) << hold.str() << " us avg allocator lock hold" << std::endl;
+}
 
+size_t PagingAllocator::getResidentMemory(const Process& process){
+    return process.getResidentPages() * mem_per_frame;
+}
+
+void PagingAllocator::setFaultCycles(int minorCycles, int majorCycles){
+    TimedLock lock(*this);
+    minorFaultCycles = minorCycles;
+    majorFaultCycles = majorCycles;
+}
+
+void PagingAllocator::setReplacementPolicy(std::unique_ptr<ReplacementPolicy> policy){
+    TimedLock lock(*this);
+    replacementPolicy = std::move(policy);
+}
+
+BackingStore& PagingAllocator::getBackingStore(){
+    return backingStore;
+}
+
+void PagingAllocator::setReclaimWatermarks(int lowPercent, int highPercent){
+    // Small frame pools still keep at least one frame in reserve when reclaim is enabled
+    size_t low = lowPercent > 0 ? std::max<size_t>(numFrames * lowPercent / 100, 1) : 0;
+    size_t high = highPercent > 0 ? std::max<size_t>(numFrames * highPercent / 100, 1) : 0;
+    reclaimer.setWatermarks(low, high);
+}
+
+// Paged processes lose single frames to faults whether pinned or not; pinning only keeps
+// deallocateOldest from swapping out everything a running process holds
+bool PagingAllocator::pin(std::shared_ptr<Process> process){
+    TimedLock lock(*this);
+    if (!pageTables.count(process->getPID())) {
+        return false;
+    }
+    pinnedProcesses.insert(process->getPID());
+    return true;
+}
+
+void PagingAllocator::unpin(std::shared_ptr<Process> process){
+    TimedLock lock(*this);
+    pinnedProcesses.erase(process->getPID());
+}
+
+// A page table always fits, so no dispatch ever waits for a release
+size_t PagingAllocator::getReleaseCount(){
+    return 0;
+}
+
+void PagingAllocator::setReleaseListener(std::function<void()> /*listener*/){
+}
+
+void PagingAllocator::setCoreCount(int nCores){
+    TimedLock lock(*this);
+    // Cached frames go back to the shared set before the caches are replaced
+    std::lock_guard<std::mutex> listLock(freeListMutex);
+    for (std::unique_ptr<FrameCache>& cache : frameCaches) {
+        for (size_t frameIndex : cache->frames) {
+            freeFrames.release(frameIndex);
+        }
+    }
+    frameCaches.clear();
+    for (int core = 0; core <= nCores; ++core) {
+        frameCaches.push_back(std::make_unique<FrameCache>());
+    }
+}
+
+PagingAllocator::TimedLock::TimedLock(PagingAllocator& allocator) : allocator(allocator)
+{
+    if (allocator.memoryMutex.try_lock()) {
+        acquired = std::chrono::steady_clock::now();
+    } else {
+        auto requested = std::chrono::steady_clock::now();
+        allocator.memoryMutex.lock();
+        acquired = std::chrono::steady_clock::now();
+        allocator.nContendedAcquisitions++;
+        allocator.lockWaitNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(acquired - requested).count();
+    }
+    allocator.nLockAcquisitions++;
+}
+
+PagingAllocator::TimedLock::~TimedLock()
+{
+    auto held = std::chrono::steady_clock::now() - acquired;
+    allocator.memoryMutex.unlock();
+    allocator.lockHoldNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(held).count();
+}
+
+void PagingAllocator::setFramePlacement(const std::string& name){
+    TimedLock lock(*this);
+    contiguousPlacement = (name == "contiguous");
+}
+
+void PagingAllocator::setHugeFrameMultiple(int multiple){
+    TimedLock lock(*this);
+    hugeFrameMultiple = static_cast<size_t>(std::max(multiple, 1));
+}
@@ -1,20 +1,114 @@
 #include "../include/Process.h"
+#include "../include/IMemoryAllocator.h"
+#include "../include/OutputLog.h"
+
+#include <algorithm>
+#include <cstring>
 
 // Constructor implementation
 Process::Process(int pid, const std::string &name, const std::string &time, int core, int minIns, int maxIns, size_t mem_per_proc, size_t mem_per_frame)
-    : Pid(pid), Name(name), Time(time), cpuCoreID(core), processState(READY), mem_per_proc(mem_per_proc), mem_per_frame(mem_per_frame), memory(nullptr){
+    : Pid(pid), Name(name), Time(time), cpuCoreID(core), processState(READY), mem_per_proc(mem_per_proc), mem_per_frame(mem_per_frame), memory(nullptr),
+      pageRng(static_cast<unsigned int>(pid)){
         calculateFrame();
     }
 
 // Method to execute the current command
-void Process::executeCurrentCommand()
+int Process::executeCurrentCommand(int& waitTicks)
+{
+    int stall = 0;
+    executeCommands(1, stall, waitTicks);
+    return stall;
+}
+
+// The interpreter: one switch per instruction over the flat array of the current block.
+// commandCounter counts executed instructions, loop iterations included.
+int Process::executeCommands(int count, int& stallCycles, int& waitTicks)
 {
-    if (commandCounter < CommandList.size())
-    {
-        CommandList[commandCounter]->setCore(cpuCoreID);
-        CommandList[commandCounter]->execute();
-        commandCounter++;
+    int end = std::min(commandCounter + count, instructions.size());
+    int start = commandCounter;
+    if (commandCounter >= end) {
+        return 0;
+    }
+    if (!execution) {
+        execution = std::make_unique<ExecutionState>();
+    }
+    ExecutionState& state = *execution;
+    uint16_t* variables = state.variables;
+
+    const Program* block = &instructions.currentBlock();
+    while (commandCounter < end) {
+        if (state.pc >= block->size()) {
+            block = &instructions.nextBlock(instructions.size() - commandCounter);
+            programFootprint = instructions.getFootprint();
+            state.pc = 0;
+        }
+        for (; commandCounter < end && state.pc < block->size(); ++commandCounter) {
+            stallCycles += touchPage();
+            const Program::Instruction& instruction = (*block)[state.pc++];
+            // Masking keeps any encoding inside the symbol table
+            const int mask = Program::VARIABLE_COUNT - 1;
+            uint16_t b = (instruction.flags & Program::LITERAL_B) ? instruction.b : variables[instruction.b & mask];
+            uint16_t c = (instruction.flags & Program::LITERAL_C) ? instruction.c : variables[instruction.c & mask];
+            switch (instruction.opcode) {
+            case Program::DECLARE:
+                variables[instruction.a & mask] = b;
+                break;
+            case Program::ADD:
+                variables[instruction.a & mask] = static_cast<uint16_t>(std::min(b + c, 65535));
+                break;
+            case Program::SUBTRACT:
+                variables[instruction.a & mask] = b > c ? static_cast<uint16_t>(b - c) : 0;
+                break;
+            case Program::PRINT:
+                if (outputLog) {
+                    outputLog->print(cpuCoreID, Pid, nPrints++, instruction.a, b, (instruction.flags & Program::HAS_B) != 0);
+                }
+                break;
+            case Program::SLEEP:
+            case Program::IO:
+                // The burst ends here so the scheduler can give the core away while the process waits
+                waitTicks += instruction.a;
+                end = commandCounter + 1;
+                break;
+            case Program::FOR:
+                state.loops[state.loopDepth++] = ExecutionState::Loop{state.pc, instruction.a};
+                break;
+            case Program::END: {
+                ExecutionState::Loop& loop = state.loops[state.loopDepth - 1];
+                if (--loop.remaining > 0) {
+                    state.pc = loop.bodyStart;
+                } else {
+                    state.loopDepth--;
+                }
+                break;
+            }
+            }
+        }
+    }
+    return commandCounter - start;
+}
+
+int Process::touchPage()
+{
+    if (!memoryAllocator || nPages == 0) {
+        return 0;
+    }
+
+    switch (accessPattern) {
+    case SEQUENTIAL:
+        currentPage = static_cast<size_t>(commandCounter) * nPages / std::max(instructions.size(), 1);
+        break;
+    case RANDOM:
+        currentPage = pageRng() % nPages;
+        break;
+    case LOCALITY:
+        // One instruction in ten jumps somewhere else, the rest stay on the current page
+        if (pageRng() % 10 == 0) {
+            currentPage = pageRng() % nPages;
+        }
+        break;
     }
+    return memoryAllocator->accessPage(*this, currentPage);
 }
 
 void Process::calculateFrame() {
@@ -43,7 +137,7 @@ void* Process::getMemory() const
 // Getter for number of commands
 int Process::getLinesOfCode() const
 {
-    return CommandList.size();
+    return instructions.size();
 }
 
 size_t Process::getMemoryRequired() const{
@@ -61,6 +155,32 @@ void Process::setCPUCOREID(int core){
     cpuCoreID = core;
 }
 
+size_t Process::getExecutionImageSize()
+{
+    return 1 + sizeof(ExecutionState);  // Whether the process has started, then its state
+}
+
+void Process::swapOutExecution(char* image)
+{
+    image[0] = execution ? 1 : 0;
+    if (execution) {
+        std::memcpy(image + 1, execution.get(), sizeof(ExecutionState));
+    } else {
+        std::memset(image + 1, 0, sizeof(ExecutionState));
+    }
+    execution.reset();
+}
+
+void Process::swapInExecution(const char* image)
+{
+    if (image[0]) {
+        execution = std::make_unique<ExecutionState>();
+        std::memcpy(execution.get(), image + 1, sizeof(ExecutionState));
+    } else {
+        execution.reset();
+    }
+}
+
 // Getter for process state
 Process::ProcessState Process::getState() const
 {
@@ -69,6 +189,11 @@ Process::ProcessState Process::getState() const
 
 void Process::setProcess(ProcessState state){
     processState = state;
+    if (state == FINISHED) {
+        instructions.release();  // Nothing runs the instructions again
+        execution.reset();
+        programFootprint = 0;
+    }
 }
 
 // Getter for PID
@@ -89,16 +214,17 @@ std::string Process::getTime() const
     return Time;
 }
 
-void Process::generate_commands(int minIns, int maxIns) {
+void Process::generate_commands(int minIns, int maxIns, int blockingPercent) {
 
     std::srand(static_cast<unsigned int>(std::time(nullptr)) + Pid);
 
     int numCommands = minIns + (std::rand() % (maxIns - minIns + 1));
 
-    for (int i = 1; i <= numCommands; ++i) {
-        std::shared_ptr<ICommand> cmd = std::make_shared<PrintCommand>(Pid, cpuCoreID, "Hello World From " + Name + " started.", Name);
-        CommandList.push_back(cmd);
-    }
+    instructions = InstructionSource(static_cast<uint32_t>(std::rand()), numCommands, blockingPercent);
+}
+
+size_t Process::getProgramFootprint() const {
+    return programFootprint;
 }
 
 void Process::setAllocTime() {
@@ -110,6 +236,53 @@ std::chrono::time_point<std::chrono::system_clock> Process::getAllocTime() {
     return allocationTime;  // Return chrono time_point
 }
 
-size_t Process::getNumPages(){
+size_t Process::getNumPages() const{
     return nPages;
-}
\ No newline at end of file
+}
+
+void Process::setOutputLog(OutputLog* log){
+    outputLog = log;
+}
+
+void Process::setMemoryAllocator(IMemoryAllocator* allocator){
+    memoryAllocator = allocator;
+}
+
+void Process::setPageAccessPattern(const std::string& pattern){
+    if (pattern == "sequential") {
+        accessPattern = SEQUENTIAL;
+    } else if (pattern == "random") {
+        accessPattern = RANDOM;
+    } else {
+        accessPattern = LOCALITY;
+    }
+}
+
+void Process::recordPageFault(bool major, int cycles){
+    if (major) {
+        majorFaults++;
+    } else {
+        minorFaults++;
+    }
+    faultCycles += cycles;
+}
+
+void Process::adjustResidentPages(int delta){
+    residentPages += delta;
+}
+
+size_t Process::getResidentPages() const{
+    return residentPages;
+}
+
+size_t Process::getMinorFaults() const{
+    return minorFaults;
+}
+
+size_t Process::getMajorFaults() const{
+    return majorFaults;
+}
+
+size_t Process::getFaultCycles() const{
+    return faultCycles;
+}
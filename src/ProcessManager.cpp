@@ -2,9 +2,12 @@
 #include "../include/CoreStateManager.h"
 #include <random>
 #include <cmath>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
 
 ProcessManager::ProcessManager(int Min_ins, int Max_ins, int NCPU, std::string SchedulerAlgo, int delays_per_exec, int quantum_cycle, CPUClock* CpuClock
-                                , size_t Max_mem, size_t Mem_per_frame, size_t Min_mem_per_proc, size_t Max_mem_per_proc)
+                                , size_t Max_mem, size_t Mem_per_frame, size_t Min_mem_per_proc, size_t Max_mem_per_proc, const ConfigOptions& options)
 {
     min_ins = Min_ins;
     max_ins = Max_ins;
@@ -16,15 +19,36 @@ ProcessManager::ProcessManager(int Min_ins, int Max_ins, int NCPU, std::string S
     mem_per_frame = Mem_per_frame;
     nCPU = NCPU;
     
-    if(max_mem == mem_per_frame){
-        memoryAllocator = new FlatMemoryAllocator(max_mem, mem_per_frame);
+    if(options.mem_allocator == "buddy"){
+        memoryAllocator = new BuddyMemoryAllocator(max_mem, mem_per_frame);
+    }else if(options.mem_allocator == "flat" || (options.mem_allocator != "paging" && max_mem == mem_per_frame)){
+        FlatMemoryAllocator* flatAllocator = new FlatMemoryAllocator(max_mem, mem_per_frame);
+        flatAllocator->setPlacement(options.flat_placement);
+        flatAllocator->setCompaction(options.compaction_threshold, options.compaction_budget);
+        memoryAllocator = flatAllocator;
     }else{
-        memoryAllocator = new PagingAllocator(max_mem, mem_per_frame);
+        PagingAllocator* pagingAllocator = new PagingAllocator(max_mem, mem_per_frame);
+        pagingAllocator->setFaultCycles(options.minor_fault_cycles, options.major_fault_cycles);
+        pagingAllocator->setCoreCount(nCPU);
+        pagingAllocator->setFramePlacement(options.frame_placement);
+        pagingAllocator->setHugeFrameMultiple(options.huge_frame_multiple);
+        memoryAllocator = pagingAllocator;
+    }
+    memoryAllocator->setReplacementPolicy(createReplacementPolicy(options.replacement_policy, options.working_set_window));
+    memoryAllocator->getBackingStore().setDebugLog(options.swap_debug_log != 0);
+    memoryAllocator->getBackingStore().setQueueLimit(options.swap_queue_depth);
+    memoryAllocator->setReclaimWatermarks(options.reclaim_low_watermark, options.reclaim_high_watermark);
+    page_access = options.page_access;
+    blocking_percent = options.blocking_percent;
+    if (options.process_output != "none") {
+        outputLog = new OutputLog(CpuClock, options.process_output);
     }
     
 
     scheduler = new Scheduler(SchedulerAlgo, delays_per_exec, NCPU, quantum_cycle, CpuClock, memoryAllocator);
     scheduler->setNumCPUs(NCPU);
+    scheduler->setExecutionMode(options.exec_mode, options.host_threads);
+    scheduler->setContextSwitchCycles(options.context_switch_cycles);
 
     schedulerThread = std::thread(&Scheduler::start, scheduler);
 }
@@ -34,7 +58,13 @@ void ProcessManager::addProcess(string name, string time)
     pid_counter++;
     shared_ptr<Process> process(new Process(pid_counter, name, time, -1, min_ins, max_ins, generate_memory(), mem_per_frame));
     processList[name] = process;
-    process->generate_commands(min_ins, max_ins);
+    process->setMemoryAllocator(memoryAllocator);
+    process->setPageAccessPattern(page_access);
+    if (outputLog) {
+        outputLog->registerProcess(process->getPID(), name);
+        process->setOutputLog(outputLog);
+    }
+    process->generate_commands(min_ins, max_ins, blocking_percent);
     scheduler->addProcess(process);
 }
 
@@ -85,13 +115,18 @@ void ProcessManager::process_smi() {
         std::shared_ptr<Process> process = pair.second;
 
         // Accessing the elements of the tuple
-        size_t size = process->getMemoryRequired();
+        size_t size = memoryAllocator->getResidentMemory(*process);
         const std::string& proc_name = process->getName();
 
         std::stringstream temp;
         temp << std::left << std::setw(30) << proc_name << " ";
         memory_usage += size;
-        temp << size << " KB" << endl;
+        temp << size << " KB";
+        if (process->getMinorFaults() + process->getMajorFaults() > 0) {
+            temp << "  faults " << process->getMinorFaults() << " minor / " << process->getMajorFaults() << " major, "
+                 << process->getFaultCycles() << " cycles";
+        }
+        temp << endl;
         running << temp.str() << endl;
     }
 
@@ -118,7 +153,9 @@ void ProcessManager::process_smi() {
     std::cout << "--------------------------------------------\n";
     
 
+    // Waiting processes have left their cores, so they do not count towards utilization
     std::cout << "CPU-Util: " << (static_cast<double>(coreUsage) / nCPU) * 100 << "%" <<endl;
+    std::cout << "Waiting processes: " << scheduler->getWaitingProcesses() << endl;
     std::cout << "Memory Usage: " << memory_usage << "KB"<< " / " << max_mem << "KB" << endl;
     std::cout << "Memory Util: " << (static_cast<double>(memory_usage) / max_mem) * 100 << "%" << endl;
     
@@ -160,12 +197,49 @@ void ProcessManager::vmstat() {
     // Print statistics in the desired format
     std::cout << "==========================================" << std::endl;
     std::cout << std::setw(12) << max_mem << " KB total memory" << std::endl;
-    std::cout << std::setw(12) << max_mem - memoryAllocator->getExternalFragmentation() << " KB used memory" << std::endl;
-    std::cout << std::setw(12) << memoryAllocator->getExternalFragmentation() << " KB free memory" << std::endl;
+    size_t freeMemory = memoryAllocator->getExternalFragmentation();
+    size_t largestFreeBlock = memoryAllocator->getLargestFreeBlock();
+    std::cout << std::setw(12) << max_mem - freeMemory << " KB used memory" << std::endl;
+    std::cout << std::setw(12) << freeMemory << " KB free memory" << std::endl;
+    std::cout << std::setw(12) << largestFreeBlock << " KB largest free block" << std::endl;
+    std::cout << std::setw(12) << memoryAllocator->getFreeBlockCount() << " free blocks" << std::endl;
+    // Free memory outside the largest block cannot hold a request that needs more than that block
+    std::cout << std::setw(12) << freeMemory - std::min(largestFreeBlock, freeMemory) << " KB external fragmentation" << std::endl;
+    std::cout << std::setw(12) << memoryAllocator->getInternalFragmentation() << " KB internal fragmentation" << std::endl;
+    memoryAllocator->printStats(std::cout);
+    memoryAllocator->getBackingStore().printStats(std::cout);
     std::cout << std::setw(12) << cpuClock->getCPUClock() - cpuClock->getActiveCPUNum() << " idle cpu ticks" << std::endl;
     std::cout << std::setw(12) << cpuClock->getActiveCPUNum() << " active cpu ticks" << std::endl;
     std::cout << std::setw(12) << cpuClock->getCPUClock() << " total cpu ticks" << std::endl;
+    std::ostringstream hostPerTick;
+    hostPerTick << std::fixed << std::setprecision(2) << cpuClock->getHostMicrosPerTick();
+    std::cout << std::setw(12) << hostPerTick.str() << " us host cpu per tick" << std::endl;
+    std::cout << std::setw(12) << cpuClock->getParticipantCount() << " clock participants" << std::endl;
+    std::cout << std::setw(12) << scheduler->getSteals() << " run queue steals" << std::endl;
+    std::cout << std::setw(12) << scheduler->getMigrations() << " process migrations" << std::endl;
+    std::cout << std::setw(12) << scheduler->getWaitingProcesses() << " processes waiting" << std::endl;
+    std::cout << std::setw(12) << scheduler->getBlockingWaits() << " sleep and io waits" << std::endl;
+    size_t instructions = scheduler->getInstructionsExecuted();
+    double hostSeconds = cpuClock->getHostCpuSeconds();
+    std::cout << std::setw(12) << instructions << " instructions executed" << std::endl;
+    std::cout << std::setw(12) << static_cast<size_t>(hostSeconds > 0 ? instructions / hostSeconds : 0) << " instructions per host cpu second" << std::endl;
+    // The allocator's list is a locked copy; processList may be growing on the generator thread
+    std::map<size_t, std::shared_ptr<Process>> residentProcesses = memoryAllocator->getProcessList();
+    size_t programBytes = 0;
+    for (const auto& entry : residentProcesses) {
+        programBytes += entry.second->getProgramFootprint();
+    }
+    std::cout << std::setw(12) << (residentProcesses.empty() ? 0 : programBytes / residentProcesses.size()) << " B avg program per resident process" << std::endl;
+    if (outputLog) {
+        outputLog->printStats(std::cout);
+    }
     std::cout << std::setw(12) << memoryAllocator->getPageIn() << " pages paged in" << std::endl;
     std::cout << std::setw(12) << memoryAllocator->getPageOut() << " pages paged out" << std::endl;
     std::cout << "==========================================" << std::endl;
 }
+
+void ProcessManager::flushOutput() {
+    if (outputLog) {
+        outputLog->flush();
+    }
+}
@@ -0,0 +1,60 @@
+#include "../include/Program.h"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+
+namespace {
+// Function statics, so other files' static initializers can intern strings, and never
+// destroyed, so threads still running at exit can read them. A deque never moves its
+// elements as it grows, so references handed out stay valid.
+std::deque<std::string>& stringTable()
+{
+    static std::deque<std::string>* strings = new std::deque<std::string>();
+    return *strings;
+}
+
+std::mutex& stringTableMutex()
+{
+    static std::mutex* mutex = new std::mutex();
+    return *mutex;
+}
+}
+
+uint16_t Program::intern(const std::string& text)
+{
+    std::lock_guard<std::mutex> lock(stringTableMutex());
+    std::deque<std::string>& strings = stringTable();
+    auto it = std::find(strings.begin(), strings.end(), text);
+    if (it != strings.end()) {
+        return static_cast<uint16_t>(it - strings.begin());
+    }
+    strings.push_back(text);
+    return static_cast<uint16_t>(strings.size() - 1);
+}
+
+const std::string& Program::getString(uint16_t index)
+{
+    std::lock_guard<std::mutex> lock(stringTableMutex());
+    return stringTable()[index];
+}
+
+void Program::reserve(size_t count)
+{
+    code.reserve(count);
+}
+
+void Program::reset()
+{
+    code.clear();
+}
+
+void Program::clear()
+{
+    std::vector<Instruction>().swap(code);
+}
+
+size_t Program::getFootprint() const
+{
+    return code.capacity() * sizeof(Instruction);
+}
@@ -0,0 +1,216 @@
+#include "../include/ReplacementPolicy.h"
+
+#include <iomanip>
+#include <sstream>
+
+void ReplacementPolicy::load(size_t id)
+{
+    nMisses++;
+    onLoad(id);
+}
+
+void ReplacementPolicy::hit(size_t id)
+{
+    nHits++;
+    onHit(id);
+}
+
+void ReplacementPolicy::reference(size_t id)
+{
+    onHit(id);
+}
+
+void ReplacementPolicy::addHits(size_t count)
+{
+    nHits += count;
+}
+
+void ReplacementPolicy::release(size_t id)
+{
+    onRelease(id);
+}
+
+void ReplacementPolicy::relocate(size_t from, size_t to)
+{
+    onRelocate(from, to);
+}
+
+size_t ReplacementPolicy::evict(const Eligible& eligible)
+{
+    size_t victim = selectVictim(eligible);
+    if (victim != NONE) {
+        nEvictions++;
+    }
+    return victim;
+}
+
+void ReplacementPolicy::printStats(std::ostream& out) const
+{
+    size_t references = nHits + nMisses;
+    std::ostringstream hitRatio;
+    hitRatio << std::fixed << std::setprecision(2) << (references ? 100.0 * nHits / references : 0.0);
+    out << std::setw(12) << getName() << " replacement policy" << std::endl;
+    out << std::setw(12) << nEvictions << " evictions" << std::endl;
+    out << std::setw(12) << hitRatio.str() << " % hit ratio" << std::endl;
+}
+
+void FifoPolicy::onLoad(size_t id)
+{
+    if (position.count(id)) {
+        return;
+    }
+    position[id] = order.insert(order.end(), id);
+}
+
+// Load order alone decides the victim, so references change nothing
+void FifoPolicy::onHit(size_t)
+{
+}
+
+void FifoPolicy::onRelease(size_t id)
+{
+    auto it = position.find(id);
+    if (it != position.end()) {
+        order.erase(it->second);
+        position.erase(it);
+    }
+}
+
+void FifoPolicy::onRelocate(size_t from, size_t to)
+{
+    auto it = position.find(from);
+    if (it != position.end()) {
+        *it->second = to;
+        position[to] = it->second;
+        position.erase(from);
+    }
+}
+
+size_t FifoPolicy::selectVictim(const Eligible& eligible)
+{
+    for (auto it = order.begin(); it != order.end(); ++it) {
+        if (accepts(eligible, *it)) {
+            size_t id = *it;
+            order.erase(it);
+            position.erase(id);
+            return id;
+        }
+    }
+    return NONE;
+}
+
+void LruPolicy::onHit(size_t id)
+{
+    auto it = position.find(id);
+    if (it != position.end()) {
+        order.splice(order.end(), order, it->second);
+    }
+}
+
+void ClockPolicy::onLoad(size_t id)
+{
+    now++;
+    if (position.count(id)) {
+        return;
+    }
+    // New units go just behind the hand so they get a full revolution before it returns
+    position[id] = ring.insert(hand, Entry{id, true, now});
+}
+
+void ClockPolicy::onHit(size_t id)
+{
+    now++;
+    auto it = position.find(id);
+    if (it != position.end()) {
+        it->second->referenced = true;
+        it->second->lastUse = now;
+    }
+}
+
+void ClockPolicy::onRelease(size_t id)
+{
+    auto it = position.find(id);
+    if (it != position.end()) {
+        take(it->second);
+    }
+}
+
+void ClockPolicy::onRelocate(size_t from, size_t to)
+{
+    auto it = position.find(from);
+    if (it != position.end()) {
+        it->second->id = to;
+        position[to] = it->second;
+        position.erase(from);
+    }
+}
+
+size_t ClockPolicy::take(std::list<Entry>::iterator it)
+{
+    size_t id = it->id;
+    position.erase(id);
+    if (it == hand) {
+        hand = ring.erase(it);
+    } else {
+        ring.erase(it);
+    }
+    return id;
+}
+
+size_t ClockPolicy::selectVictim(const Eligible& eligible)
+{
+    // Two revolutions suffice: the first one clears the reference bit of every eligible unit.
+    // Ineligible units keep their bit, they are simply passed over.
+    for (size_t scanned = 0; scanned < 2 * ring.size(); ++scanned) {
+        if (hand == ring.end()) {
+            hand = ring.begin();
+        }
+        if (accepts(eligible, hand->id)) {
+            if (!hand->referenced) {
+                return take(hand);
+            }
+            hand->referenced = false;
+        }
+        ++hand;
+    }
+    return NONE;
+}
+
+WorkingSetPolicy::WorkingSetPolicy(size_t window) : window(window)
+{
+}
+
+size_t WorkingSetPolicy::selectVictim(const Eligible& eligible)
+{
+    auto oldest = ring.end();
+    for (size_t scanned = 0; scanned < 2 * ring.size(); ++scanned) {
+        if (hand == ring.end()) {
+            hand = ring.begin();
+        }
+        if (!accepts(eligible, hand->id)) {
+            ++hand;
+            continue;
+        }
+        if (hand->referenced) {
+            hand->referenced = false;
+        } else if (now - hand->lastUse > window) {
+            return take(hand);  // Outside the working set
+        } else if (oldest == ring.end() || hand->lastUse < oldest->lastUse) {
+            oldest = hand;
+        }
+        ++hand;
+    }
+    return oldest == ring.end() ? NONE : take(oldest);
+}
+
+std::unique_ptr<ReplacementPolicy> createReplacementPolicy(const std::string& name, size_t workingSetWindow)
+{
+    if (name == "lru") {
+        return std::make_unique<LruPolicy>();
+    } else if (name == "clock" || name == "second-chance") {
+        return std::make_unique<ClockPolicy>();
+    } else if (name == "working-set") {
+        return std::make_unique<WorkingSetPolicy>(workingSetWindow);
+    }
+    return std::make_unique<FifoPolicy>();
+}
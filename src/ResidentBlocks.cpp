@@ -0,0 +1,100 @@
+#include "../include/ResidentBlocks.h"
+#include "../include/Process.h"
+
+ResidentBlocks::ResidentBlocks(BackingStore& backingStore)
+    : backingStore(backingStore), policy(createReplacementPolicy("fifo", 0))
+{
+}
+
+void ResidentBlocks::setPolicy(std::unique_ptr<ReplacementPolicy> replacementPolicy)
+{
+    policy = std::move(replacementPolicy);
+}
+
+void ResidentBlocks::printStats(std::ostream& out) const
+{
+    policy->printStats(out);
+}
+
+void ResidentBlocks::load(size_t block, Process& process, void* handle, char* pool)
+{
+    policy->load(block);
+
+    auto swapped = swapRecords.find(process.getPID());
+    if (swapped != swapRecords.end()) {
+        size_t bytes = pool ? process.getMemoryRequired() : 0;
+        backingStore.swapInProcess(process, swapped->second, pool ? pool + block : nullptr, bytes);
+        backingStore.release(swapped->second);
+        swapRecords.erase(swapped);
+    }
+    pinnedProcesses.insert(process.getPID());
+    // Set under the allocator's lock so an eviction never sees a placed process without its memory
+    process.setMemory(handle);
+}
+
+void ResidentBlocks::release(size_t block, Process& process)
+{
+    policy->release(block);
+    pinnedProcesses.erase(process.getPID());
+    process.setMemory(nullptr);
+    nReleases++;
+}
+
+void ResidentBlocks::relocate(size_t from, size_t to)
+{
+    policy->relocate(from, to);
+}
+
+void ResidentBlocks::pin(size_t block, const Process& process)
+{
+    pinnedProcesses.insert(process.getPID());
+    // The block is in use for the whole quantum, so a dispatch is one reference rather than
+    // one per instruction
+    policy->hit(block);
+}
+
+void ResidentBlocks::unpin(const Process& process)
+{
+    pinnedProcesses.erase(process.getPID());
+    nReleases++;
+}
+
+bool ResidentBlocks::isPinned(const Process& process) const
+{
+    return pinnedProcesses.count(process.getPID()) != 0;
+}
+
+size_t ResidentBlocks::swapOutVictim(const std::map<size_t, std::shared_ptr<Process>>& processList, const char* pool, size_t& nSlots)
+{
+    size_t block = policy->evict([&](size_t index) {
+        auto it = processList.find(index);
+        return it != processList.end() && !isPinned(*it->second);
+    });
+    if (block == ReplacementPolicy::NONE) {
+        return block;
+    }
+
+    Process& victim = *processList.at(block);
+    size_t bytes = pool ? victim.getMemoryRequired() : 0;
+    std::vector<size_t>& slots = swapRecords[victim.getPID()];
+    slots = backingStore.swapOutProcess(victim, pool ? pool + block : nullptr, bytes);
+    nSlots = slots.size();
+    return block;
+}
+
+size_t ResidentBlocks::getReleaseCount() const
+{
+    return nReleases.load();
+}
+
+void ResidentBlocks::setReleaseListener(std::function<void()> listener)
+{
+    releaseListener = std::move(listener);
+}
+
+void ResidentBlocks::notifyRelease() const
+{
+    if (releaseListener) {
+        releaseListener();
+    }
+}
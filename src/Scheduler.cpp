@@ -7,10 +7,15 @@
 #include <iostream>
 #include <chrono>
 #include <iomanip>
+#include <algorithm>
+#include <climits>
 
 Scheduler::Scheduler(std::string SchedulerAlgo, int delays_per_exec, int nCPU, int quantum_cycle, CPUClock* CpuClock, IMemoryAllocator* memoryAllocator) 
 : running(false), activeThreads(0), readyThreads(0), schedulerAlgo(SchedulerAlgo), delay_per_exec(delays_per_exec)
-, nCPU(nCPU), quantum_cycle(quantum_cycle), cpuClock(CpuClock), memoryAllocator(memoryAllocator){}
+, nCPU(nCPU), quantum_cycle(quantum_cycle), cpuClock(CpuClock), memoryAllocator(memoryAllocator){
+    createRunQueues();
+    memoryAllocator->setReleaseListener([this] { wakeMemoryWaiters(); });
+}
 
 
 void Scheduler::addProcess(std::shared_ptr<Process> process) {
@@ -19,8 +24,23 @@ void Scheduler::addProcess(std::shared_ptr<Process> process) {
         startMemoryLog();
     }
 
+    // Spread new arrivals across the per-core queues
+    int coreID = static_cast<int>(nextQueue++ % nCPU) + 1;
+    pushProcess(coreID, process);
+    wakeIdleCore();
+}
+
+void Scheduler::wakeIdleCore() {
     std::unique_lock<std::mutex> lock(queueMutex);
-    processQueue.push(process);
+    if (idleCores == 0) {
+        return;
+    }
+
+    // Hand the current tick to a sleeping core so the virtual clock waits for it to pick this up
+    if (cpuClock->isVirtual() && wakeTokens < idleCores) {
+        wakeTokens++;
+        cpuClock->holdTick();
+    }
     queueCondition.notify_one();
 }
 
@@ -31,6 +51,87 @@ void Scheduler::setAlgorithm(const std::string& algorithm) {
 void Scheduler::setNumCPUs(int num) {
     nCPU = num;
     CoreStateManager::getInstance().initialize(nCPU);
+    createRunQueues();
+}
+
+// Run queues are indexed by core ID, index 0 is unused
+void Scheduler::createRunQueues() {
+    runQueues.clear();
+    for (int i = 0; i <= nCPU; ++i) {
+        runQueues.emplace_back(new RunQueue());
+    }
+}
+
+// Returns the length of the core's queue after the push
+size_t Scheduler::pushProcess(int coreID, std::shared_ptr<Process> process) {
+    std::lock_guard<std::mutex> lock(runQueues[coreID]->mutex);
+    runQueues[coreID]->processes.push_back(process);
+    queuedProcesses++;
+    return runQueues[coreID]->processes.size();
+}
+
+// Own queue first, then steal from the back of the other cores' queues
+std::shared_ptr<Process> Scheduler::popProcess(int coreID) {
+    if (queuedProcesses == 0) {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(runQueues[coreID]->mutex);
+        std::deque<std::shared_ptr<Process>>& own = runQueues[coreID]->processes;
+        if (!own.empty()) {
+            std::shared_ptr<Process> process = own.front();
+            own.pop_front();
+            queuedProcesses--;
+            return process;
+        }
+    }
+
+    for (int i = 1; i < nCPU && queuedProcesses > 0; ++i) {
+        int victim = (coreID - 1 + i) % nCPU + 1;
+        std::lock_guard<std::mutex> lock(runQueues[victim]->mutex);
+        std::deque<std::shared_ptr<Process>>& other = runQueues[victim]->processes;
+        if (!other.empty()) {
+            std::shared_ptr<Process> process = other.back();
+            other.pop_back();
+            queuedProcesses--;
+            steals++;
+            return process;
+        }
+    }
+    return nullptr;
+}
+
+// Counts a dispatch on a different core than the process last ran on
+void Scheduler::recordDispatch(std::shared_ptr<Process> process, int coreID) {
+    int lastCore = process->getCPUCoreID();
+    if (lastCore != -1 && lastCore != coreID) {
+        migrations++;
+    }
+}
+
+size_t Scheduler::getSteals() const {
+    return steals.load();
+}
+
+size_t Scheduler::getMigrations() const {
+    return migrations.load();
+}
+
+size_t Scheduler::getInstructionsExecuted() const {
+    size_t total = 0;
+    for (const std::unique_ptr<CoreContext>& core : cores) {
+        total += core->instructions.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+size_t Scheduler::getWaitingProcesses() const {
+    return waitingProcesses.load();
+}
+
+size_t Scheduler::getBlockingWaits() const {
+    return blockingWaits.load();
 }
 
 void Scheduler::setDelays(int delay) {
@@ -45,16 +146,47 @@ void Scheduler::setQuantumCycle(int Quantum_cycle){
     quantum_cycle = Quantum_cycle;
 }
 
+void Scheduler::setContextSwitchCycles(int cycles) {
+    contextSwitchCycles = cycles;
+}
+
+void Scheduler::setExecutionMode(const std::string& mode, int hostThreads) {
+    execMode = mode;
+    hostThreadCount = hostThreads;
+}
+
 void Scheduler::start() {
     running = true;
-    for (int i = 1; i <= nCPU; ++i) {
+
+    // "threads" gives every core its own worker, "pool" multiplexes them onto the host cores
+    int nWorkers = nCPU;
+    if (execMode == "pool") {
+        nWorkers = hostThreadCount > 0 ? hostThreadCount : static_cast<int>(std::thread::hardware_concurrency());
+        nWorkers = std::max(1, std::min(nWorkers, nCPU));
+    }
+
+    cores.clear();
+    workers.clear();
+    for (int i = 0; i < nWorkers; ++i) {
+        workers.emplace_back(new Worker());
+        workers[i]->slot = cpuClock->registerParticipant();  // Each worker owns a clock slot
+    }
+    for (int i = 0; i <= nCPU; ++i) {
+        cores.emplace_back(new CoreContext());
+        cores[i]->coreID = i;
+        if (i > 0) {
+            workers[(i - 1) % nWorkers]->cores.push_back(cores[i].get());
+        }
+    }
+
+    for (int i = 0; i < nWorkers; ++i) {
         workerThreads.emplace_back(&Scheduler::run, this, i);
     }
 
 
     {
         std::unique_lock<std::mutex> lock(startMutex);
-        startCondition.wait(lock, [this] { return readyThreads == nCPU; });
+        startCondition.wait(lock, [this] { return readyThreads == static_cast<int>(workers.size()); });
     }
 }
 
@@ -62,12 +194,15 @@ void Scheduler::startMemoryLog() {
     memoryLog = true;
     memoryLoggingThread = std::thread([this]() {
         
-        std::unique_lock<std::mutex> lock(cpuClock->getMutex());
+        int lastTick = cpuClock->getCPUClock();
         
         // Start an infinite loop to monitor the CPU clock ticks and log memory
         while (running) {
-            // Wait for the clock tick to increment
-            cpuClock->getCondition().wait(lock);
+            // Wait for the clock to move; the virtual clock may skip several ticks at once
+            int tick = cpuClock->waitForAdvance(lastTick);
+            if (tick == lastTick) {
+                continue;
+            }
 
             bool anyCoreActive = false;
             // Check if at least one CPU core is running
@@ -79,17 +214,126 @@ void Scheduler::startMemoryLog() {
             }
 
              if (anyCoreActive) {
-                cpuClock->incrementActiveCPUNum();
+                cpuClock->incrementActiveCPUNum(tick - lastTick);
              }
+             lastTick = tick;
             
         }
     });
 }
 
 
+// Called with queueMutex held; idle workers stop holding back the virtual clock until work arrives.
+// A worker whose cores are all parked for memory cannot take queued work, so it waits for a
+// release on memoryCondition, where wakeIdleCore never sends the wakeup meant for an idle core.
+void Scheduler::waitForWork(std::unique_lock<std::mutex>& lock, Worker& worker) {
+    bool& participating = worker.participating;
+    bool canTakeWork = std::any_of(worker.cores.begin(), worker.cores.end(),
+                                   [](const CoreContext* core) { return core->phase == CoreContext::IDLE; });
+    std::condition_variable& condition = canTakeWork ? queueCondition : memoryCondition;
+    if (!hasWork(worker, canTakeWork) && running) {
+        leaveClock(worker);
+
+        if (canTakeWork) {
+            idleCores++;
+        }
+        worker.sleepingOn = &condition;
+        do {
+            condition.wait(lock);
+
+            // wakeMemoryWaiters or wakeIdleCore already held the tick on behalf of the core it woke
+            if (worker.heldJoin) {
+                worker.heldJoin = false;
+                cpuClock->joinHeldParticipant(worker.slot);
+                participating = true;
+            } else if (canTakeWork && wakeTokens > 0) {
+                wakeTokens--;
+                cpuClock->joinHeldParticipant(worker.slot);
+                participating = true;
+            }
+        } while (!participating && !hasWork(worker, canTakeWork) && running);
+        worker.sleepingOn = nullptr;
+        if (canTakeWork) {
+            idleCores--;
+        }
+    }
+
+    if (running) {
+        joinClock(worker);
+    }
+}
+
+bool Scheduler::hasWork(const Worker& worker, bool canTakeWork) const {
+    if (canTakeWork && queuedProcesses > 0) {
+        return true;
+    }
+    return std::any_of(worker.cores.begin(), worker.cores.end(),
+                       [](const CoreContext* core) { return core->memoryReleased.load(); });
+}
+
+// Parks the core in DISPATCH until the next release. A release since releases was read may
+// have come before the core was listed, so it retries right away in that case.
+void Scheduler::waitForMemory(Worker& worker, CoreContext& core, size_t releases) {
+    core.waitingForMemory = true;
+    core.wakeTick = INT_MAX;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        memoryWaiters.emplace_back(&worker, &core);
+        nMemoryWaiters = memoryWaiters.size();
+    }
+
+    if (memoryAllocator->getReleaseCount() != releases) {
+        wakeMemoryWaiters();
+    }
+}
+
+// Called by the allocator after every unpin and free, without its lock
+void Scheduler::wakeMemoryWaiters() {
+    if (nMemoryWaiters.load() == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    for (std::pair<Worker*, CoreContext*>& waiter : memoryWaiters) {
+        Worker& worker = *waiter.first;
+        waiter.second->memoryReleased = true;
+        if (!worker.sleepingOn) {
+            continue;  // Sees the release on its next tick
+        }
+
+        // Hold the current tick so the virtual clock waits for the retry
+        if (cpuClock->isVirtual() && !worker.heldJoin) {
+            worker.heldJoin = true;
+            cpuClock->holdTick();
+        }
+        worker.sleepingOn->notify_all();
+    }
+    memoryWaiters.clear();
+    nMemoryWaiters = 0;
+}
+
+void Scheduler::joinClock(Worker& worker) {
+    if (!worker.participating) {
+        cpuClock->joinParticipant(worker.slot);
+        worker.participating = true;
+    }
+}
+
+void Scheduler::leaveClock(Worker& worker) {
+    if (worker.participating) {
+        cpuClock->leaveParticipant(worker.slot);
+        worker.participating = false;
+    }
+}
+
+
 void Scheduler::stop() {
     running = false;
-    queueCondition.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queueCondition.notify_all();
+        memoryCondition.notify_all();
+    }
 
     // Stop memory logging thread
     if (memoryLoggingThread.joinable()) {
@@ -105,243 +349,331 @@ void Scheduler::stop() {
 }
 
 
-void Scheduler::run(int coreID) {
+void Scheduler::run(int workerID) {
     {
         std::lock_guard<std::mutex> lock(startMutex);
         readyThreads++;
-        if (readyThreads == nCPU) {
+        if (readyThreads == static_cast<int>(workers.size())) {
             startCondition.notify_one();
         }
     }
-    if (schedulerAlgo == "rr") {
-        scheduleRR(coreID);
-    } else if (schedulerAlgo == "fcfs") {
-        scheduleFCFS(coreID);
-    }
-}
 
-void Scheduler::scheduleFCFS(int coreID)
-{
-    while (running) {
-        std::shared_ptr<Process> process;
-        int assignedCore = -1;
+    Worker& worker = *workers[workerID];
+    int tick = cpuClock->getCPUClock();
 
-        {
-            std::unique_lock<std::mutex> lock(queueMutex);
-            queueCondition.wait(lock, [this] { return !processQueue.empty() || !running; });
+    while (running) {
+        if (tick >= nextSleeperWake.load()) {
+            wakeSleepers(tick);
+        }
 
-            if (!running)
-                break;
+        int nextWake = INT_MAX;
 
-            process = processQueue.front();
-            processQueue.pop();
+        for (CoreContext* core : worker.cores) {
+            stepCore(worker, *core, tick);
+            if (core->phase != CoreContext::IDLE) {
+                nextWake = std::min(nextWake, core->wakeTick);
+            }
         }
 
-        // Find the first available core
-        for (int i = 1; i <= nCPU; ++i) {
-            if (!CoreStateManager::getInstance().getCoreState(i)) { // If core is not in use
-                assignedCore = i;
-                break; // Assign to the first available core
-            }
+        // With nothing to run, a worker still keeps the clock for the next process to wake, so
+        // the virtual clock cannot skip past it. The worker that blocked a process sees it here.
+        if (nextWake == INT_MAX && nextSleeperWake.load() != TimerWheel::NO_WAKE) {
+            joinClock(worker);
+            nextWake = nextSleeperWake.load();
         }
 
-        if (assignedCore == -1) {
-            // No core is available, process will be put back in the queue
+        if (nextWake == INT_MAX) {
+            // Every core of this worker is idle, sleep until a process arrives
             std::unique_lock<std::mutex> lock(queueMutex);
-            processQueue.push(process);
-            continue;
+            waitForWork(lock, worker);
+            tick = cpuClock->getCPUClock();
+        } else if (nextWake > tick) {
+            tick = cpuClock->waitForTick(worker.slot, nextWake);
         }
+    }
+}
 
-        if (process) {
-            {
-                std::lock_guard<std::mutex> lock(activeThreadsMutex);
-                activeThreads++;
-                if (activeThreads > nCPU) {
-                    std::cerr << "Error: Exceeded CPU limit!" << std::endl;
-                    activeThreads--;
-                    continue;
+// Advances one core as far as it can go at this tick, then leaves it parked until core.wakeTick
+void Scheduler::stepCore(Worker& worker, CoreContext& core, int tick)
+{
+    while (running) {
+        switch (core.phase) {
+        case CoreContext::IDLE:
+            core.process = popProcess(core.coreID);
+            if (!core.process) {
+                return;
+            }
+            joinClock(worker);
+            core.phase = CoreContext::DISPATCH;
+            break;
+
+        case CoreContext::DISPATCH:
+            // A core parked for memory retries only once a release has woken it
+            if (core.waitingForMemory) {
+                if (!core.memoryReleased.exchange(false)) {
+                    return;
                 }
+                core.waitingForMemory = false;
             }
-
-            void* memory = memoryAllocator->allocate(process);
-
-            //if allocation was succesful
-            if(memory){
-                process->setAllocTime();
-                process->setMemory(memory);
+            if (!dispatchProcess(worker, core, tick)) {
+                return;
             }
+            break;
 
-            //no free memory, replace some
-            if(!memory){
-                do{
-                    memoryAllocator->deallocateOldest(process->getMemoryRequired());
-                    memory = memoryAllocator->allocate(process);
-                    if(memory){
-                        process->setAllocTime();
-                        process->setMemory(memory);
-                    }                        
-                }while(!memory);
+        case CoreContext::EXECUTE:
+            if (tick < core.wakeTick) {
+                return;
             }
-            
-
-            //logActiveThreads(assignedCore, process);
-            process->setProcess(Process::ProcessState::RUNNING);
-            process->setCPUCOREID(assignedCore);
-            CoreStateManager::getInstance().setCoreState(assignedCore, true, process->getName()); // Mark core as in use
-
-            int lastClock = cpuClock->getCPUClock();
-            bool firstCommandExecuted = false;
-            int cycleCounter = 0;
-
-            while (process->getCommandCounter() < process->getLinesOfCode()) {
-                {
-                    // Wait for the next CPU cycle
-                    std::unique_lock<std::mutex> lock(cpuClock->getMutex());
-                    cpuClock->getCondition().wait(lock, [&] {
-                        return cpuClock->getCPUClock() > lastClock;
-                    });
-                    lastClock = cpuClock->getCPUClock();
-                }
+            if (schedulerAlgo == "rr") {
+                executeRR(core, tick);
+            } else {
+                executeFCFS(core, tick);
+            }
+            break;
 
-                // Execute the first command immediately, then apply delay for subsequent commands
-                if (!firstCommandExecuted || (++cycleCounter >= delay_per_exec)) {
-                    process->executeCurrentCommand();
-                    firstCommandExecuted = true;
-                    cycleCounter = 0; // Reset cycle counter after each execution
-                }
+        case CoreContext::SWITCH:
+            if (tick < core.wakeTick) {
+                return;
             }
+            finishQuantum(core, tick);
+            break;
+        }
+    }
+}
 
-            process->setProcess(Process::ProcessState::FINISHED);
+// Picks the core, memory and bookkeeping for core.process; returns false if it has to retry later
+bool Scheduler::dispatchProcess(Worker& worker, CoreContext& core, int tick)
+{
+    std::shared_ptr<Process> process = core.process;
+    core.runCore = core.coreID;
 
-            {
-                memoryAllocator->deallocate(process);
-                std::lock_guard<std::mutex> lock(activeThreadsMutex);
-                activeThreads--;
+    if (schedulerAlgo == "fcfs") {
+        // Find the first available core
+        core.runCore = -1;
+        for (int i = 1; i <= nCPU; ++i) {
+            if (!CoreStateManager::getInstance().getCoreState(i)) { // If core is not in use
+                core.runCore = i;
+                break; // Assign to the first available core
             }
-            //logActiveThreads(assignedCore, nullptr);
-            queueCondition.notify_one();
         }
 
-        CoreStateManager::getInstance().setCoreState(assignedCore, false, ""); // Mark core as idle
+        if (core.runCore == -1) {
+            // No core is available, process will be put back in the queue
+            pushProcess(core.coreID, process);
+            core.process.reset();
+            core.phase = CoreContext::IDLE;
+            return false;
+        }
     }
-}
 
+    // A process that still has its memory is pinned to it for the run; otherwise allocate,
+    // which pins the new memory as well
+    if (!memoryAllocator->pin(process)) {
+        size_t releases = memoryAllocator->getReleaseCount();
+        void* memory = memoryAllocator->allocate(process);
 
-void Scheduler::scheduleRR(int coreID)
-{
-    while (running) {
-        std::shared_ptr<Process> process;
-
-        {
-            // Minimize lock time by immediately checking if the queue is empty and only waiting if necessary
-            std::unique_lock<std::mutex> lock(queueMutex);
-            queueCondition.wait(lock, [this] { return !processQueue.empty() || !running; });
+        //no free memory, replace some. Eviction never waits: only processes on a core are
+        // off limits, so the outcome does not depend on how cores are spread over workers
+        while (!memory && memoryAllocator->deallocateOldest(process->getMemoryRequired())) {
+            memory = memoryAllocator->allocate(process);
+        }
+        if (!memory) {
+            // Everything resident is running; retry once one of them has left its core
+            waitForMemory(worker, core, releases);
+            return false;
+        }
 
-            if (!running) break;
+        //allocation was succesful; the allocator has already recorded the memory on the process
+        process->setAllocTime();
+    }
 
-            process = processQueue.front();
-            processQueue.pop();
+    {
+        std::lock_guard<std::mutex> lock(activeThreadsMutex);
+        activeThreads++;
+        if (activeThreads > nCPU) {
+            std::cerr << "Error: Exceeded CPU limit!" << std::endl;
+            activeThreads--;
+            memoryAllocator->unpin(process);
+            core.process.reset();
+            core.phase = CoreContext::IDLE;
+            return true;
         }
+    }
 
-        if (process) {
-            {
-                std::lock_guard<std::mutex> lock(activeThreadsMutex);
-                activeThreads++;
-                if (activeThreads > nCPU) {
-                    std::cerr << "Error: Exceeded CPU limit!" << std::endl;
-                    activeThreads--;
-                    continue;
-                }
-            }
+    recordDispatch(process, core.runCore);
+    process->setProcess(Process::ProcessState::RUNNING);
+    process->setCPUCOREID(core.runCore);
+    CoreStateManager::getInstance().setCoreState(core.runCore, true, process->getName()); // Mark core as in use
+
+    core.quantum = 0;
+    core.cycleCounter = 0;
+    core.firstCommandExecuted = (schedulerAlgo == "rr");
+    core.phase = CoreContext::EXECUTE;
 
-            // Check if the process already has memory allocated
-            void* memory = process->getMemory();
+    // RR without delays runs straight away, everything else starts on the next CPU cycle
+    core.wakeTick = (schedulerAlgo == "rr" && delay_per_exec == 0) ? tick : tick + 1;
+    return true;
+}
+
+// One CPU cycle of FCFS: the process keeps the core until it finishes
+void Scheduler::executeFCFS(CoreContext& core, int tick)
+{
+    std::shared_ptr<Process> process = core.process;
+    int stallCycles = 0;
+    int waitTicks = 0;
+    int executedBefore = process->getCommandCounter();
+
+    if (delay_per_exec == 0) {
+        // Without delays the whole burst is one unit of work
+        process->executeCommands(process->getLinesOfCode() - process->getCommandCounter(), stallCycles, waitTicks);
+    }
+    // Execute the first command immediately, then apply delay for subsequent commands
+    else if (!core.firstCommandExecuted || (++core.cycleCounter >= delay_per_exec)) {
+        stallCycles = process->executeCurrentCommand(waitTicks);
+        core.firstCommandExecuted = true;
+        core.cycleCounter = 0; // Reset cycle counter after each execution
+    }
+    core.instructions.fetch_add(process->getCommandCounter() - executedBefore, std::memory_order_relaxed);
 
+    // SLEEP and IO give the core up; a wait after the last instruction has nothing to wait for
+    if (waitTicks > 0 && process->getCommandCounter() < process->getLinesOfCode()) {
+        beginWait(core, tick, stallCycles, waitTicks);
+        return;
+    }
 
-            if (!memory) {
-                memory = memoryAllocator->allocate(process);
+    // Page faults stall the core, and the process keeps it until they are over
+    if (process->getCommandCounter() < process->getLinesOfCode() || stallCycles > 0) {
+        core.wakeTick = tick + 1 + stallCycles;
+        return;
+    }
 
-                //if allocation was succesful
-                if(memory){
-                    process->setAllocTime();
-                    process->setMemory(memory);
-                }
+    process->setProcess(Process::ProcessState::FINISHED);
 
-                //no free memory, replace some
-                if(!memory){
-                    do{
-                        memoryAllocator->deallocateOldest(process->getMemoryRequired());
-                        memory = memoryAllocator->allocate(process);
-                        if(memory){
-                            process->setAllocTime();
-                            process->setMemory(memory);
-                        }                        
-                    }while(!memory);
-                }
-            }
-            
-            
+    {
+        memoryAllocator->deallocate(process);
+        std::lock_guard<std::mutex> lock(activeThreadsMutex);
+        activeThreads--;
+    }
 
-            process->setProcess(Process::ProcessState::RUNNING);
-            process->setCPUCOREID(coreID);
-            CoreStateManager::getInstance().setCoreState(coreID, true, process->getName()); // Mark core as in use
-
-            int quantum = 0;
-            int lastClock = cpuClock->getCPUClock();
-            bool firstCommandExecuted = true;
-            int cycleCounter = 0;
-            //std::this_thread::sleep_for(std::chrono::microseconds(2000));
-
-            while (process->getCommandCounter() < process->getLinesOfCode() && quantum < quantum_cycle) {
-                // Efficient wait mechanism; prevent unnecessary busy-waiting
-                if (delay_per_exec != 0) {
-                    std::unique_lock<std::mutex> lock(cpuClock->getMutex());
-                    cpuClock->getCondition().wait(lock, [&] {
-                        return cpuClock->getCPUClock() > lastClock;
-                    });
-                    lastClock = cpuClock->getCPUClock();
-                } else {
-                    //std::this_thread::sleep_for(std::chrono::microseconds(1000)); // Continue on if no delay is needed
-                }
+    CoreStateManager::getInstance().setCoreState(core.runCore, false, ""); // Mark core as idle
+    core.process.reset();
+    core.phase = CoreContext::IDLE;
+}
 
+// One CPU cycle of RR; without delays the whole quantum runs as one unit
+void Scheduler::executeRR(CoreContext& core, int tick)
+{
+    std::shared_ptr<Process> process = core.process;
+    int stallCycles = 0;
+    int waitTicks = 0;
+    int executedBefore = process->getCommandCounter();
 
+    if (delay_per_exec == 0) {
+        core.quantum += process->executeCommands(quantum_cycle - core.quantum, stallCycles, waitTicks);
+    }
+    // Execute the process commands with delay handling
+    else if (!core.firstCommandExecuted || (++core.cycleCounter >= delay_per_exec)) {
+        stallCycles = process->executeCurrentCommand(waitTicks);
+        core.firstCommandExecuted = false;
+        core.cycleCounter = 0;
+        core.quantum++;
+    }
+    core.instructions.fetch_add(process->getCommandCounter() - executedBefore, std::memory_order_relaxed);
 
-                // Execute the process commands with delay handling
-                if (!firstCommandExecuted || (++cycleCounter >= delay_per_exec)) {
-                    process->executeCurrentCommand();
-                    firstCommandExecuted = false;
-                    cycleCounter = 0;
-                    quantum++;
-                }
-            }
+    // SLEEP and IO end the quantum early
+    if (waitTicks > 0 && process->getCommandCounter() < process->getLinesOfCode()) {
+        beginWait(core, tick, stallCycles, waitTicks);
+        return;
+    }
 
-            // Log memory state after each execution cycle
-            {
-                std::lock_guard<std::mutex> lock(logMutex);
-            }
-            std::this_thread::sleep_for(std::chrono::microseconds(2000));
+    // Page faults stall the core on top of the cycle the instruction took
+    if (process->getCommandCounter() < process->getLinesOfCode() && core.quantum < quantum_cycle) {
+        core.wakeTick = tick + 1 + stallCycles;
+        return;
+    }
 
-            // If the process hasn't finished, move it back to the ready queue
-            if (process->getCommandCounter() < process->getLinesOfCode()) {
-                process->setProcess(Process::ProcessState::READY);
-                std::lock_guard<std::mutex> lock(queueMutex);
-                processQueue.push(process);
-            } else {
-                process->setProcess(Process::ProcessState::FINISHED);
-                memoryAllocator->deallocate(process);
-                process->setMemory(nullptr);
-            }
+    // The context switch is charged in simulated cycles before the core is free again
+    core.phase = CoreContext::SWITCH;
+    core.wakeTick = tick + stallCycles + contextSwitchCycles;
+}
 
-            {
-                std::lock_guard<std::mutex> lock(activeThreadsMutex);
-                activeThreads--;
-            }
+// The process waits off the core from waitUntil on. The core stays busy only for the burst's
+// page faults and, under RR, the context switch; FCFS frees it on this tick.
+void Scheduler::beginWait(CoreContext& core, int tick, int stallCycles, int waitTicks)
+{
+    core.waitUntil = tick + 1 + stallCycles + waitTicks;
+    core.phase = CoreContext::SWITCH;
+    core.wakeTick = tick + stallCycles + (schedulerAlgo == "rr" ? contextSwitchCycles : 0);
+}
 
-            queueCondition.notify_one();
+// End of an RR quantum or of a burst cut short by a wait: block, requeue or retire the process and free the core
+void Scheduler::finishQuantum(CoreContext& core, int tick)
+{
+    std::shared_ptr<Process> process = core.process;
+
+    if (core.waitUntil > 0) {
+        // Waiting processes hold no core and no pins, so their pages may be evicted meanwhile
+        memoryAllocator->unpin(process);
+        blockingWaits++;
+        if (core.waitUntil > tick) {
+            process->setProcess(Process::ProcessState::WAITING);
+            sleepProcess(process, core.waitUntil);
+        } else {
+            // The context switch outlasted the wait
+            process->setProcess(Process::ProcessState::READY);
+            pushProcess(core.runCore, process);
+            wakeIdleCore();
         }
+        core.waitUntil = 0;
+    }
+    // If the process hasn't finished, move it back to this core's ready queue
+    else if (process->getCommandCounter() < process->getLinesOfCode()) {
+        process->setProcess(Process::ProcessState::READY);
+        memoryAllocator->unpin(process);
+
+        // This core picks it up again next; only wake a stealer if others are waiting behind it
+        if (pushProcess(core.coreID, process) > 1) {
+            wakeIdleCore();
+        }
+    } else {
+        process->setProcess(Process::ProcessState::FINISHED);
+        memoryAllocator->deallocate(process);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(activeThreadsMutex);
+        activeThreads--;
+    }
+
+    // Mark the core as idle after processing
+    CoreStateManager::getInstance().setCoreState(core.runCore, false, "");
+    core.process.reset();
+    core.phase = CoreContext::IDLE;
+}
+
+void Scheduler::sleepProcess(std::shared_ptr<Process> process, int wakeTick)
+{
+    std::lock_guard<std::mutex> lock(sleepersMutex);
+    sleepers.schedule(wakeTick, std::move(process));
+    waitingProcesses = sleepers.size();
+    nextSleeperWake = sleepers.nextWake();
+}
+
+// Moves every process due by this tick back to the run queue of the core it last ran on
+void Scheduler::wakeSleepers(int tick)
+{
+    std::vector<std::shared_ptr<Process>> due;
+    {
+        std::lock_guard<std::mutex> lock(sleepersMutex);
+        sleepers.expire(tick, due);
+        waitingProcesses = sleepers.size();
+        nextSleeperWake = sleepers.nextWake();
+    }
 
-        // Mark the core as idle after processing
-        CoreStateManager::getInstance().setCoreState(coreID, false, "");
+    for (std::shared_ptr<Process>& process : due) {
+        process->setProcess(Process::ProcessState::READY);
+        pushProcess(process->getCPUCoreID(), process);
+        wakeIdleCore();
     }
 }
 
@@ -0,0 +1,86 @@
+#include "../include/TimerWheel.h"
+
+#include <algorithm>
+
+TimerWheel::TimerWheel(size_t nSlots)
+    : slots(std::max<size_t>(nSlots, 1))
+{
+}
+
+std::vector<TimerWheel::Timer>& TimerWheel::slotOf(int tick)
+{
+    return slots[static_cast<size_t>(tick) % slots.size()];
+}
+
+void TimerWheel::schedule(int wakeTick, std::shared_ptr<Process> process)
+{
+    // A tick already expired would never be looked at again, so it goes to the next one
+    wakeTick = std::max(wakeTick, lastTick + 1);
+    slotOf(wakeTick).push_back(Timer{wakeTick, std::move(process)});
+    earliest = std::min(earliest, wakeTick);
+    count++;
+}
+
+void TimerWheel::expire(int tick, std::vector<std::shared_ptr<Process>>& due)
+{
+    if (tick <= lastTick) {
+        return;
+    }
+    if (earliest > tick) {
+        lastTick = tick;
+        return;
+    }
+
+    // A jump of a whole revolution or more visits every slot once
+    int from = std::max(earliest, tick - static_cast<int>(slots.size()) + 1);
+    for (int t = from; t <= tick; ++t) {
+        std::vector<Timer>& slot = slotOf(t);
+        for (size_t i = 0; i < slot.size();) {
+            if (slot[i].wakeTick <= tick) {
+                due.push_back(std::move(slot[i].process));
+                slot[i] = std::move(slot.back());
+                slot.pop_back();
+                count--;
+            } else {
+                ++i;
+            }
+        }
+    }
+    lastTick = tick;
+    findNextWake(tick);
+}
+
+void TimerWheel::findNextWake(int after)
+{
+    earliest = NO_WAKE;
+    if (count == 0) {
+        return;
+    }
+
+    // The first slot holding a timer of its own round is the earliest
+    for (int t = after + 1; t <= after + static_cast<int>(slots.size()); ++t) {
+        for (const Timer& timer : slotOf(t)) {
+            if (timer.wakeTick == t) {
+                earliest = t;
+                return;
+            }
+        }
+    }
+
+    // Everything left waits more than a revolution
+    for (const std::vector<Timer>& slot : slots) {
+        for (const Timer& timer : slot) {
+            earliest = std::min(earliest, timer.wakeTick);
+        }
+    }
+}
+
+int TimerWheel::nextWake() const
+{
+    return earliest;
+}
+
+size_t TimerWheel::size() const
+{
+    return count;
+}